@@ -1,22 +1,174 @@
 #include "CPUTick.h"
+#include <algorithm>
 
-void CPUTick::start(int batch_process_freq) {
+void CPUTick::start(int tickMillis) {
+	this->tickMillis = tickMillis;
 	running = true;
 	tickThread = std::thread([=] {
+		std::vector<std::function<void()>> due;
 		while (running) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(batch_process_freq));
-			tick++;
+			std::this_thread::sleep_for(std::chrono::milliseconds(tickMillis));
+			fireTimers(++tick);
+			{
+				std::lock_guard<std::mutex> lock(clockMutex);
+				takeDueDeferred(due);
+			}
+			for (auto& resume : due) {
+				resume();
+			}
+			due.clear();
 		}
 		});
 }
 
+void CPUTick::startVirtual() {
+	std::lock_guard<std::mutex> lock(clockMutex);
+	virtualTime = true;
+	running = true;
+}
+
 void CPUTick::stop() {
-	running = false;
+	{
+		std::lock_guard<std::mutex> lock(clockMutex);
+		running = false;
+	}
+	clockCv.notify_all();
 	if (tickThread.joinable()) {
 		tickThread.join();
 	}
 }
 
+bool CPUTick::pinThread(int cpu) {
+	return CpuAffinity::pin(tickThread, cpu);
+}
+
 uint64_t CPUTick::getTick() const {
 	return tick.load();
-}
\ No newline at end of file
+}
+
+bool CPUTick::isVirtual() const {
+	return virtualTime;
+}
+
+void CPUTick::addTimerSource(std::function<void(uint64_t)> onTick, std::function<uint64_t()> nextTimer) {
+	timerSources.push_back({ onTick, nextTimer });
+}
+
+void CPUTick::fireTimers(uint64_t now) {
+	for (auto& source : timerSources) {
+		source.onTick(now);
+	}
+}
+
+uint64_t CPUTick::nextTimerExpiry() {
+	uint64_t next = UINT64_MAX;
+	for (auto& source : timerSources) {
+		next = std::min(next, source.nextTimer());
+	}
+	return next;
+}
+
+void CPUTick::waitTicks(uint64_t ticks) {
+	if (ticks == 0) return;
+
+	if (!virtualTime) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(ticks * tickMillis));
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(clockMutex);
+	uint64_t target = tick + ticks;
+	deadlines.insert(target);
+	blocked++;
+	while (tick < target && running) {
+		if (blocked == attached && !advancing) {
+			advance(lock);
+			continue;
+		}
+		clockCv.wait(lock);
+	}
+}
+
+void CPUTick::defer(uint64_t ticks, std::function<void()> resume) {
+	std::unique_lock<std::mutex> lock(clockMutex);
+	if (!running) return;
+
+	deferred.emplace(tick + ticks, std::move(resume));
+	if (!virtualTime) return;
+
+	blocked++;
+	if (blocked == attached && !advancing) {
+		advance(lock);
+	}
+}
+
+// Must hold clockMutex
+void CPUTick::takeDueDeferred(std::vector<std::function<void()>>& due) {
+	while (!deferred.empty() && deferred.begin()->first <= tick) {
+		due.push_back(std::move(deferred.begin()->second));
+		deferred.erase(deferred.begin());
+		if (virtualTime) {
+			blocked--;
+		}
+	}
+}
+
+void CPUTick::attach() {
+	if (!virtualTime) return;
+	std::lock_guard<std::mutex> lock(clockMutex);
+	attached++;
+}
+
+// The last thread to leave drives any timers that are still pending, since
+// nobody else is left to move the clock.
+void CPUTick::detach() {
+	if (!virtualTime) return;
+	std::unique_lock<std::mutex> lock(clockMutex);
+	attached--;
+	if (blocked == attached && !advancing && running) {
+		advance(lock);
+	}
+}
+
+// Every attached thread is waiting: move to the earliest deadline or timer
+// and release whoever was waiting for it. Waiters are unblocked here, and the
+// timer callback runs before anyone is woken, so the clock cannot run past a
+// process the callback hands back to a core. Anyone who blocks or leaves while
+// this runs does not advance the clock themselves, so it goes round again.
+void CPUTick::advance(std::unique_lock<std::mutex>& lock) {
+	while (running) {
+		uint64_t next = deadlines.empty() ? UINT64_MAX : *deadlines.begin();
+		if (!deferred.empty()) {
+			next = std::min(next, deferred.begin()->first);
+		}
+		uint64_t timer = nextTimerExpiry();
+		next = std::min(next, timer);
+		if (next == UINT64_MAX) return;
+
+		if (next > tick) {
+			tick = next;
+		}
+		while (!deadlines.empty() && *deadlines.begin() <= tick) {
+			deadlines.erase(deadlines.begin());
+			blocked--;
+		}
+		std::vector<std::function<void()>> due;
+		takeDueDeferred(due);
+
+		if (timer <= tick || !due.empty()) {
+			advancing = true;
+			lock.unlock();
+			if (timer <= tick) {
+				fireTimers(tick);
+			}
+			for (auto& resume : due) {
+				resume();
+			}
+			lock.lock();
+			advancing = false;
+		}
+		clockCv.notify_all();
+
+		if (blocked != attached) return;
+	}
+}
@@ -2,18 +2,65 @@
 #include <atomic>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <functional>
 #include <vector>
+#include <set>
+#include <map>
 #include <chrono>
+#include "CpuAffinity.h"
 
 
 class CPUTick {
 public:
-	void start(int batch_process_freq);
+	// Real time: one tick every tickMillis milliseconds
+	void start(int tickMillis);
+	// Virtual time: the tick only moves when every attached thread is
+	// waiting, and then jumps straight to the earliest wake-up
+	void startVirtual();
 	void stop();
+	// Pins the real-time tick thread; there is none in virtual mode
+	bool pinThread(int cpu);
 	uint64_t getTick() const;
+	bool isVirtual() const;
+
+	void waitTicks(uint64_t ticks);
+	// Like waitTicks, but instead of blocking the caller, resume runs once the
+	// ticks have passed. The caller counts as waiting until then.
+	void defer(uint64_t ticks, std::function<void()> resume);
+
+	// Threads that consume virtual time must be attached while they run
+	void attach();
+	void detach();
+
+	// Timers owned outside the clock: onTick runs whenever the tick moves,
+	// nextTimer reports the earliest pending expiry so virtual time can jump to
+	// it. Register before the clock starts.
+	void addTimerSource(std::function<void(uint64_t)> onTick, std::function<uint64_t()> nextTimer);
 
 private:
+	void advance(std::unique_lock<std::mutex>& lock);
+	void fireTimers(uint64_t now);
+	void takeDueDeferred(std::vector<std::function<void()>>& due);
+	uint64_t nextTimerExpiry();
+
 	std::atomic_bool running = false;
 	std::thread tickThread;
 	std::atomic<uint64_t> tick = 0;
-};
\ No newline at end of file
+	int tickMillis = 1;
+
+	bool virtualTime = false;
+	std::mutex clockMutex;
+	std::condition_variable clockCv;
+	int attached = 0;
+	int blocked = 0;
+	bool advancing = false;
+	std::multiset<uint64_t> deadlines;
+	std::multimap<uint64_t, std::function<void()>> deferred;
+
+	struct TimerSource {
+		std::function<void(uint64_t)> onTick;
+		std::function<uint64_t()> nextTimer;
+	};
+	std::vector<TimerSource> timerSources;
+};
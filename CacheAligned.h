@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+constexpr std::size_t CacheLineSize = 64;
+
+// Base for per-core blocks that worker threads write concurrently. The size
+// rounds up to whole cache lines, and heap allocation is aligned by hand since
+// operator new only guarantees 16 bytes before C++17.
+struct alignas(CacheLineSize) CacheAligned {
+    static void* operator new(std::size_t size) {
+        void* raw = ::operator new(size + CacheLineSize);
+        auto address = (reinterpret_cast<std::uintptr_t>(raw) + CacheLineSize) & ~(CacheLineSize - 1);
+        void* aligned = reinterpret_cast<void*>(address);
+        static_cast<void**>(aligned)[-1] = raw;
+        return aligned;
+    }
+
+    static void operator delete(void* aligned) {
+        if (aligned) {
+            ::operator delete(static_cast<void**>(aligned)[-1]);
+        }
+    }
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include "Scheduler.h"
+
+// The per-core step every scheduler runs, compiled once per policy so that
+// picking the next process and settling a finished slice are direct calls
+// the compiler can inline into the hot loop. A policy derives from
+// CoreEngine<itself> and provides
+//   std::shared_ptr<Process> takeNext(int coreId, unsigned& quantum);
+//   void finishSlice(int coreId, std::shared_ptr<Process> process, unsigned cyclesUsed);
+// takeNext returns the next process for the core and how many instructions it
+// may run, or nullptr when there is nothing for this core; finishSlice runs
+// once the process finished, went to sleep, used its quantum or its core was
+// retired. A policy with per-core queues also provides drainCore(coreId).
+template <typename Policy>
+class CoreEngine : public Scheduler {
+public:
+    using Scheduler::Scheduler;
+
+protected:
+    void runCore(int coreId) override;
+
+private:
+    void retireCore(Policy& policy, int coreId);
+};
+
+// One host step of an emulated core: pick a process if it has none, run its
+// slice, and hand the host thread back whenever the core has to wait on the
+// clock. The core resubmits itself rather than looping, so every core gets a
+// turn on the pool.
+template <typename Policy>
+void CoreEngine<Policy>::runCore(int coreId) {
+    if (!running) return;
+    auto& core = *cores[coreId];
+    auto& slice = core.slice;
+    auto& policy = static_cast<Policy&>(*this);
+
+    if (!slice.process) {
+        if (!isOnline(coreId)) {
+            retireCore(policy, coreId);
+            return;
+        }
+
+        slice.process = policy.takeNext(coreId, slice.quantum);
+        if (!slice.process) {
+            // Publish that this core is idle before the final check, so an
+            // arrival racing with us either is seen here or signals us.
+            core.idle = true;
+            slice.process = policy.takeNext(coreId, slice.quantum);
+            if (!slice.process) {
+                if (autoscaling) {
+                    autoscale(true);
+                }
+                if (!isOnline(coreId)) {
+                    retireCore(policy, coreId);
+                }
+                else {
+                    parkCore(coreId);
+                }
+                return;
+            }
+            core.idle = false;
+        }
+        core.current = slice.process.get();
+        recordDispatch(coreId, *slice.process);
+        slice.cyclesUsed = 0;
+        slice.executed = false;
+        slice.executeTime = {};
+    }
+
+    Process& process = *slice.process;
+    if (!slice.executed) {
+        const bool pacedInRealTime = !clock->isVirtual() && delays_per_exec > 0;
+        auto executeStart = std::chrono::steady_clock::now();
+        while (slice.cyclesUsed < slice.quantum && process.getState() == ProcessState::Running &&
+            running && isOnline(coreId)) {
+            process.executeNextInstruction();
+            slice.cyclesUsed++;
+            if (pacedInRealTime) {
+                slice.executeTime += std::chrono::steady_clock::now() - executeStart;
+                clock->defer(delays_per_exec, [this, coreId]() { submitCore(coreId); });
+                return;
+            }
+        }
+        slice.executeTime += std::chrono::steady_clock::now() - executeStart;
+        slice.executed = true;
+
+        // In virtual time the slice is charged at once and the clock jumps
+        // straight to its end
+        uint64_t cost = static_cast<uint64_t>(slice.cyclesUsed) * (1 + delays_per_exec);
+        if (clock->isVirtual() && cost > 0) {
+            clock->defer(cost, [this, coreId]() { submitCore(coreId); });
+            return;
+        }
+    }
+
+    auto finished = std::move(slice.process);
+    slice.process = nullptr;
+    core.current = nullptr;
+    policy.finishSlice(coreId, finished, slice.cyclesUsed);
+    if (autoscaling) {
+        autoscale(false);
+    }
+    submitCore(coreId);
+}
+
+// A core past the active count ends its slice early; once the slice is
+// settled it gives its queue away and parks until it is brought back
+template <typename Policy>
+void CoreEngine<Policy>::retireCore(Policy& policy, int coreId) {
+    cores[coreId]->idle = false;
+    policy.drainCore(coreId);
+    parkCore(coreId);
+}
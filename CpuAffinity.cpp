@@ -0,0 +1,94 @@
+#include "CpuAffinity.h"
+#include <sstream>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+CpuAffinity::CpuAffinity(const std::string& spec) : spec(spec) {
+    if (spec == "none" || spec == "compact" || spec == "scatter") return;
+
+    std::istringstream list(spec);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        std::istringstream range(item);
+        int first = -1, last = -1;
+        char dash = 0;
+        range >> first;
+        if (range >> dash) {
+            range >> last;
+        }
+        else {
+            last = first;
+        }
+
+        if (first < 0 || last < first || (dash != 0 && dash != '-') || last >= hostCpuCount()) {
+            valid = false;
+            break;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    if (cpus.empty()) {
+        valid = false;
+    }
+    if (!valid) {
+        this->spec = "none";
+        cpus.clear();
+    }
+}
+
+bool CpuAffinity::isEnabled() const {
+    return spec != "none";
+}
+
+bool CpuAffinity::isValid() const {
+    return valid;
+}
+
+const std::string& CpuAffinity::getSpec() const {
+    return spec;
+}
+
+int CpuAffinity::cpuFor(int slot, int slots) const {
+    int hostCpus = hostCpuCount();
+    if (spec == "compact") {
+        return slot % hostCpus;
+    }
+    if (spec == "scatter") {
+        // More threads than CPUs wrap around like compact
+        if (slots > hostCpus) return slot % hostCpus;
+        return static_cast<int>(static_cast<long long>(slot) * hostCpus / slots);
+    }
+    if (!cpus.empty()) {
+        return cpus[slot % cpus.size()];
+    }
+    return -1;
+}
+
+int CpuAffinity::hostCpuCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool CpuAffinity::pin(std::thread& thread, int cpu) {
+    if (cpu < 0 || !thread.joinable()) return false;
+#if defined(_WIN32)
+    if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) return false;
+    return SetThreadAffinityMask(thread.native_handle(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
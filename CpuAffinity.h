@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+
+// Maps host threads onto host CPUs. Slots are numbered in start order: the
+// host pool threads first, then the clock thread.
+//   none     leave placement to the OS (default)
+//   compact  fill CPUs in order, so threads share caches
+//   scatter  spread threads evenly over all CPUs
+//   a list   such as "0,2,4-7", used round-robin
+class CpuAffinity {
+public:
+    CpuAffinity() = default;
+    explicit CpuAffinity(const std::string& spec);
+
+    bool isEnabled() const;
+    bool isValid() const;
+    const std::string& getSpec() const;
+    // The CPU for slot out of slots, or -1 when not pinning
+    int cpuFor(int slot, int slots) const;
+
+    static int hostCpuCount();
+    static bool pin(std::thread& thread, int cpu);
+
+private:
+    std::string spec = "none";
+    std::vector<int> cpus;
+    bool valid = true;
+};
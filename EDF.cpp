@@ -0,0 +1,111 @@
+#include "EDF.h"
+
+EDFScheduler::EDFScheduler(int numCores, int quantum, bool rejectInfeasible, int delays_per_exec,
+    size_t maxMemory, size_t frameSize)
+    : QueueScheduler(numCores, delays_per_exec, maxMemory, frameSize),
+    quantum(static_cast<unsigned>(std::max(1, quantum))),
+    rejectInfeasible(rejectInfeasible) {
+}
+
+EDFScheduler::~EDFScheduler() {
+    stop();
+}
+
+// Virtual time charges an instruction 1 + delays_per_exec ticks. Real time
+// paces it at delays_per_exec ticks; with no delay it takes well under a
+// tick and is counted as one, so the test stays an upper bound.
+uint64_t EDFScheduler::ticksPerInstruction() const {
+    if (clock->isVirtual()) return 1 + delays_per_exec;
+    return static_cast<uint64_t>(std::max(1, delays_per_exec));
+}
+
+uint64_t EDFScheduler::remainingTicks(const std::shared_ptr<Process>& process) const {
+    uint64_t remaining = process->getInstructionCount() - process->getCurrentInstructionIndex();
+    return remaining * ticksPerInstruction();
+}
+
+// The test runs against the running total of owed work, so admission does
+// not depend on how many deadlines are pending. Pending deadlines later than
+// the new one are counted too, which only makes the test stricter.
+bool EDFScheduler::admit(const std::shared_ptr<Process>& process, std::string& notice) {
+    if (!process->hasDeadline()) return true;
+
+    uint64_t now = clock->getTick();
+    uint64_t deadline = process->getDeadline();
+
+    // The process itself can only ever use one core
+    uint64_t slack = deadline > now ? deadline - now : 0;
+    uint64_t own = remainingTicks(process);
+    uint64_t demand = totalDemand + own;
+    uint64_t capacity = slack * getActiveCores();
+
+    if (own > slack || demand > capacity) {
+        notice = "Deadline " + std::to_string(deadline) + " infeasible at tick " +
+            std::to_string(now) + " (" + std::to_string(demand) + " ticks of work, " +
+            std::to_string(capacity) + " available)";
+        if (rejectInfeasible) {
+            rejectedCount++;
+            return false;
+        }
+        flaggedCount++;
+        notice = "Flagged: " + notice;
+    }
+
+    pendingDemand[process->getId()] = own;
+    totalDemand += own;
+    return true;
+}
+
+void EDFScheduler::pushReady(std::shared_ptr<Process> process) {
+    uint64_t deadline = process->hasDeadline() ? process->getDeadline() : UINT64_MAX;
+    readyHeap.push({ deadline, nextSequence++, process });
+}
+
+std::shared_ptr<Process> EDFScheduler::popReady() {
+    if (readyHeap.empty()) return nullptr;
+
+    auto process = readyHeap.top().process;
+    readyHeap.pop();
+    return process;
+}
+
+size_t EDFScheduler::readyCount() const {
+    return readyHeap.size();
+}
+
+unsigned EDFScheduler::quantumFor(const std::shared_ptr<Process>& process) {
+    return quantum;
+}
+
+void EDFScheduler::charge(const std::shared_ptr<Process>& process, unsigned cyclesUsed) {
+    auto it = pendingDemand.find(process->getId());
+    if (it == pendingDemand.end()) return;
+
+    uint64_t paid = std::min<uint64_t>(it->second, static_cast<uint64_t>(cyclesUsed) * ticksPerInstruction());
+    it->second -= paid;
+    totalDemand -= paid;
+}
+
+void EDFScheduler::retire(const std::shared_ptr<Process>& process) {
+    if (!process->hasDeadline()) return;
+
+    auto it = pendingDemand.find(process->getId());
+    if (it != pendingDemand.end()) {
+        totalDemand -= it->second;
+        pendingDemand.erase(it);
+    }
+    if (clock->getTick() > process->getDeadline()) {
+        deadlinesMissed++;
+    }
+    else {
+        deadlinesMet++;
+    }
+}
+
+void EDFScheduler::describeQueues(std::vector<std::string>& lines) {
+    lines.push_back("EDF ready: " + std::to_string(readyHeap.size()));
+    lines.push_back("Deadlines met: " + std::to_string(deadlinesMet) +
+        "  missed: " + std::to_string(deadlinesMissed) +
+        "  flagged at admission: " + std::to_string(flaggedCount) +
+        "  rejected: " + std::to_string(rejectedCount));
+}
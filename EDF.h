@@ -0,0 +1,56 @@
+#pragma once
+#include "QueueScheduler.h"
+#include <queue>
+#include <unordered_map>
+
+// Earliest-deadline-first, re-picked at every quantum boundary. Processes
+// without a deadline run after every process that has one. On arrival the
+// work still owed to every admitted deadline, plus the new process, is
+// compared with what the cores can deliver before the new deadline; an
+// infeasible process is either rejected or admitted and flagged.
+class EDFScheduler : public QueueScheduler<EDFScheduler> {
+public:
+    EDFScheduler(int numCores, int quantum, bool rejectInfeasible, int delays_per_exec,
+        size_t maxMemory, size_t frameSize);
+    ~EDFScheduler() override;
+
+protected:
+    friend class QueueScheduler<EDFScheduler>;
+    bool admit(const std::shared_ptr<Process>& process, std::string& notice);
+    void pushReady(std::shared_ptr<Process> process);
+    std::shared_ptr<Process> popReady();
+    size_t readyCount() const;
+    unsigned quantumFor(const std::shared_ptr<Process>& process);
+    void charge(const std::shared_ptr<Process>& process, unsigned cyclesUsed);
+    void retire(const std::shared_ptr<Process>& process);
+    void describeQueues(std::vector<std::string>& lines) override;
+
+private:
+    struct Entry {
+        uint64_t deadline;
+        uint64_t sequence;
+        std::shared_ptr<Process> process;
+
+        bool operator>(const Entry& other) const {
+            if (deadline != other.deadline) return deadline > other.deadline;
+            return sequence > other.sequence;
+        }
+    };
+
+    uint64_t ticksPerInstruction() const;
+    uint64_t remainingTicks(const std::shared_ptr<Process>& process) const;
+
+    unsigned quantum;
+    bool rejectInfeasible;
+    uint64_t nextSequence = 0;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> readyHeap;
+    // Ticks of work still owed to each admitted process with a deadline,
+    // paid down every slice, and their sum
+    std::unordered_map<int, uint64_t> pendingDemand;
+    uint64_t totalDemand = 0;
+
+    size_t deadlinesMet = 0;
+    size_t deadlinesMissed = 0;
+    size_t flaggedCount = 0;
+    size_t rejectedCount = 0;
+};
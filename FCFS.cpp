@@ -1,14 +1,10 @@
 #include "FCFS.h"
 #include <chrono>
 #include <iostream>
+#include <climits>
 
 FCFSScheduler::FCFSScheduler(int numCores, size_t maxMemory, size_t frameSize, int delays_per_exec)
-    : Scheduler(numCores, maxMemory, frameSize),
-    delays_per_exec(delays_per_exec) {
-    for (int i = 0; i < numCores; ++i) {
-        workerThreads.emplace_back(&FCFSScheduler::workerLoop, this, i);
-    }
-    schedulerThread = std::thread(&FCFSScheduler::schedulerLoop, this);
+    : CoreEngine(numCores, maxMemory, frameSize, delays_per_exec) {
 }
 
 
@@ -17,75 +13,86 @@ FCFSScheduler::~FCFSScheduler() {
 }
 
 void FCFSScheduler::addProcess(std::shared_ptr<Process> process) {
+    trackProcess(process);
+    process->mustTransition(ProcessState::New, ProcessState::Ready);
     std::lock_guard<std::mutex> lock(queueMutex);
-    processQueue.push(process);
-    cv.notify_one();
+    processQueue.push_back(process);
+    dispatchLocked();
 }
 
-void FCFSScheduler::schedulerLoop() {
-    while (running) {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        cv.wait(lock, [this]() { return !processQueue.empty() || !running; });
-        if (!running) break;
-
-        while (!processQueue.empty()) {
-            int core = findAvailableCore();
-            if (core == -1) break;
+// A process waking from SLEEP arrived before anything still queued, so it
+// goes back to the head of the line
+void FCFSScheduler::resumeProcess(std::shared_ptr<Process> process) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    processQueue.push_front(process);
+    dispatchLocked();
+}
 
-            auto process = processQueue.front();
-            processQueue.pop();
-            process->setAssignedCore(core);
-            coreAvailable[core] = false;
-            processHandler.insertProcess(process);
-            cv.notify_all();
-        }
-        lock.unlock();
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+// Dispatch happens on the arrival or completion that makes it possible, and
+// wakes only the core the process was assigned to. Must hold queueMutex.
+void FCFSScheduler::dispatchLocked() {
+    while (!processQueue.empty()) {
+        int core = findAvailableCore();
+        if (core == -1) break;
+
+        auto process = processQueue.front();
+        processQueue.pop_front();
+        process->setAssignedCore(core);
+        cores[core]->available = false;
+        processHandler.insertProcess(process);
+        signalCore(core);
     }
 }
 
-void FCFSScheduler::workerLoop(int coreId) {
-    while (running) {
-        std::shared_ptr<Process> process;
-
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            cv.wait(lock, [this, coreId]() {
-                return !running || processHandler.hasUnfinishedProcessOnCore(coreId);
-                });
-            if (!running) break;
-
-            auto coreProcs = processHandler.getProcessesByCore(coreId);
-            auto it = std::find_if(coreProcs.begin(), coreProcs.end(), [](const auto& p) {
-                return !p->getIsFinished();
-                });
-            if (it != coreProcs.end()) {
-                process = *it;
-            }
-        }
+// Dispatch already put the process on this core; it runs to completion or
+// until it sleeps
+std::shared_ptr<Process> FCFSScheduler::takeNext(int coreId, unsigned& quantum) {
+    quantum = UINT_MAX;
+    auto process = processHandler.getFirstUnfinishedProcessOnCore(coreId);
+    if (process) {
+        process->mustTransition(ProcessState::Ready, ProcessState::Running, coreId);
+    }
+    return process;
+}
 
-        if (process) {
-            while (!process->getIsFinished() && running) {
-                process->executeNextInstruction();
+// The process is classified once: after parkSleeping the timer wheel owns
+// it, and it may already have been woken onto another core
+void FCFSScheduler::finishSlice(int coreId, std::shared_ptr<Process> process, unsigned cyclesUsed) {
+    ProcessState state = process->getState();
+    if (state == ProcessState::Finished) {
+        processHandler.markProcessFinished(process->getId());
+    }
+    else if (state == ProcessState::Sleeping) {
+        // Release the core; the process rejoins the queue when it wakes
+        parkSleeping(process);
+    }
+    else {
+        // Cut short because this core was retired; it was running, so it
+        // goes ahead of everything still queued
+        process->mustTransition(ProcessState::Running, ProcessState::Ready, -1);
+        std::lock_guard<std::mutex> lock(queueMutex);
+        processQueue.push_front(process);
+    }
 
-                auto start = std::chrono::high_resolution_clock::now();
-                while (std::chrono::duration_cast<std::chrono::milliseconds>(
-                    std::chrono::high_resolution_clock::now() - start).count() < delays_per_exec) {
-                    // Busy wait for delay
-                }
-            }
+    std::lock_guard<std::mutex> lock(queueMutex);
+    cores[coreId]->available = true;
+    dispatchLocked();
+}
 
-            {
-                std::lock_guard<std::mutex> lock(queueMutex);
-                if (process->getIsFinished()) {
-                    process->setIsFinished(true);
-                }
-                coreAvailable[coreId] = true;
-                cv.notify_all();
-            }
-        }
+// A process dispatched to a core that was retired before it could take it
+// goes back to the head of the line, and the core stops counting as busy
+void FCFSScheduler::drainCore(int coreId) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    auto process = processHandler.getFirstUnfinishedProcessOnCore(coreId);
+    if (process && process->getState() == ProcessState::Ready) {
+        process->setAssignedCore(-1);
+        processQueue.push_front(process);
     }
+    cores[coreId]->available = true;
+    dispatchLocked();
 }
 
-
-
+size_t FCFSScheduler::readyDepth() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return processQueue.size();
+}
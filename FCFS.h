@@ -1,10 +1,10 @@
 #pragma once
-#include <queue>
+#include <deque>
 #include <memory>
-#include "Scheduler.h"
+#include "CoreEngine.h"
 
 
-class FCFSScheduler : public Scheduler {
+class FCFSScheduler : public CoreEngine<FCFSScheduler> {
 public:
     FCFSScheduler(int numCores, size_t maxMemory, size_t frameSize, int delays_per_exec);
     ~FCFSScheduler() override;
@@ -12,8 +12,12 @@ public:
     void addProcess(const std::shared_ptr<Process> process);
 
 private:
-    void schedulerLoop() override;
-    int delays_per_exec;
-    void workerLoop(int coreId) override;
-    std::queue<std::shared_ptr<Process>> processQueue;
-};
\ No newline at end of file
+    void dispatchLocked();
+    void resumeProcess(std::shared_ptr<Process> process) override;
+    size_t readyDepth() override;
+    friend class CoreEngine<FCFSScheduler>;
+    std::shared_ptr<Process> takeNext(int coreId, unsigned& quantum);
+    void finishSlice(int coreId, std::shared_ptr<Process> process, unsigned cyclesUsed);
+    void drainCore(int coreId);
+    std::deque<std::shared_ptr<Process>> processQueue;
+};
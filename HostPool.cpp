@@ -0,0 +1,64 @@
+#include "HostPool.h"
+
+HostPool::~HostPool() {
+    stop();
+}
+
+bool HostPool::start(int threadCount) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return false;
+
+    running = true;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&HostPool::run, this);
+    }
+    return true;
+}
+
+void HostPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+        tasks.clear();
+    }
+    cv.notify_all();
+
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads.clear();
+}
+
+void HostPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        tasks.push_back(std::move(task));
+    }
+    cv.notify_one();
+}
+
+int HostPool::getThreadCount() const {
+    return static_cast<int>(threads.size());
+}
+
+bool HostPool::pinThread(int index, int cpu) {
+    return CpuAffinity::pin(threads[index], cpu);
+}
+
+void HostPool::run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() { return !tasks.empty() || !running; });
+            if (!running) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
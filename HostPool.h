@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "CpuAffinity.h"
+
+// A fixed set of host threads that the emulated cores are multiplexed onto.
+// Cores submit one step at a time and resubmit themselves to keep running,
+// so every core gets its turn however many there are.
+class HostPool {
+public:
+    ~HostPool();
+
+    // Starting an already running pool does nothing and returns false
+    bool start(int threadCount);
+    void stop();
+    void submit(std::function<void()> task);
+    int getThreadCount() const;
+    bool pinThread(int index, int cpu);
+
+private:
+    void run();
+
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool running = false;
+};
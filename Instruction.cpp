@@ -1,229 +1,185 @@
 #include "Instruction.h"
-#include "Process.h"
-#include "ProcessHandler.h"
-#include "CPUTick.h"
-#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+	std::mutex sharedMutex;
+	std::unordered_multimap<size_t, std::weak_ptr<const Program>> sharedPrograms;
+	size_t sweepAt = 64;
+}
+
+std::shared_ptr<const Program> Program::share(Program program)
+{
+	size_t key = program.hash();
+	std::lock_guard<std::mutex> lock(sharedMutex);
+
+	auto range = sharedPrograms.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		auto existing = it->second.lock();
+		if (existing && *existing == program) {
+			return existing;
+		}
+	}
 
-Instruction::Instruction(Process* process, InstructionType instructionType)
-{
-	this->process = process;
-	this->instructionType = instructionType;
-}
+	// Entries whose program has been dropped are swept whenever the table
+	// doubles, so it tracks the live programs rather than every one built
+	if (sharedPrograms.size() >= sweepAt) {
+		for (auto it = sharedPrograms.begin(); it != sharedPrograms.end();) {
+			it = it->second.expired() ? sharedPrograms.erase(it) : std::next(it);
+		}
+		sweepAt = std::max<size_t>(64, sharedPrograms.size() * 2);
+	}
 
-Instruction::InstructionType Instruction::getInstructionType()
-{
-	return instructionType;
+	auto shared = std::make_shared<const Program>(std::move(program));
+	sharedPrograms.emplace(key, shared);
+	return shared;
 }
 
-void Instruction::execute() {
-}
 
-PrintInstruction::PrintInstruction(Process* process, const std::string& toPrint)
-	: Instruction(process, Instruction::InstructionType::PRINT),
-	toPrint(toPrint)
+void Program::print(const std::string& toPrint, bool withProcessName)
 {
-}
-
-void PrintInstruction::execute() {
-	std::stringstream msg;
-
-	if (process->getSymbolTable().checkVarExists(toPrint)) {
-		msg << "Value from " << toPrint << ": "
-			<< process->getSymbolTable().retrieveValue(toPrint) << std::endl;
-	}
-	else {
-		msg << toPrint << std::endl;
-	}
-
-}
-
-std::string PrintInstruction::getDetails() const {
-	return "Message: " + toPrint;
+	emit(Instruction::InstructionType::PRINT, 0, intern(strings, toPrint), withProcessName ? 1 : 0);
 }
 
 /*
 * DECLARE INSTRUCTION: declares a uint16 with a variable name "var", and a default "value"
 */
-
-DeclareInstruction::DeclareInstruction(Process* process, const std::string& varName, uint16_t value)
-	: Instruction(process, Instruction::InstructionType::DECLARE),
-	varName(varName),
-	value(value)  // Direct initialization of uint16_t
-{
-}
-
-void DeclareInstruction::execute()
+void Program::declare(const std::string& varName, uint16_t value)
 {
-	performDeclaration();
-}
-
-bool DeclareInstruction::performDeclaration() {
-	if (!process->getSymbolTable().checkVarExists(varName)) {
-		process->getSymbolTable().insertVariable(
-			varName,
-			SymbolTable::DataType::INTEGER,
-			std::to_string(value)  // Convert uint16_t to string for storage
-		);
-		return true;
-	}
-	return false;
-}
-
-std::string DeclareInstruction::getDetails() const {
-	return "Declared variable: " + varName + " with value: " + process->getSymbolTable().retrieveValue(varName);
+	emit(Instruction::InstructionType::DECLARE, 1 << 1, intern(variables, varName), value);
 }
 
 /*
 * ADD INSTRUCTION: performs an addition operation var 1 = var2/value + var3/value
 * var1, var2, var3 are variables. Variables are automatically declared with a value of 0 if they have not been declared beforehand. Can also add a uint16 value.
 */
-AddInstruction::AddInstruction(Process* process, const std::string& var1,
-	const std::string& var2, const std::string& var3)
-	: Instruction(process, InstructionType::ADD),
-	var1(var1), var2(var2), var3(var3) {
-}
-
-void AddInstruction::execute()
+void Program::add(const std::string& var1, const std::string& var2, const std::string& var3)
 {
-	add();
+	uint8_t literals = 0;
+	uint16_t a = intern(variables, var1);
+	uint16_t b = operand(var2, 1, literals);
+	uint16_t c = operand(var3, 2, literals);
+	emit(Instruction::InstructionType::ADD, literals, a, b, c);
 }
 
-uint16_t AddInstruction::getValue(const std::string& var)
+void Program::subtract(const std::string& var1, const std::string& var2, const std::string& var3)
 {
-	//check if the var is a number
-	if (checkNumber(var)) {
-		return static_cast<uint16_t>(std::stoi(var));
-	}
-
-	//if its not a number, and it doesn't exist, declare it as 
-	if (!process->getSymbolTable().checkVarExists(var)) {
-		DeclareInstruction decl(process, var, 0);
-		decl.execute();
-	}
-
-	return static_cast<uint16_t>(std::stoi(process->getSymbolTable().retrieveValue(var)));
+	uint8_t literals = 0;
+	uint16_t a = intern(variables, var1);
+	uint16_t b = operand(var2, 1, literals);
+	uint16_t c = operand(var3, 2, literals);
+	emit(Instruction::InstructionType::SUBTRACT, literals, a, b, c);
 }
 
-std::string AddInstruction::getDetails() const {
-	return "ADD " + process->getSymbolTable().retrieveValue(var1) + " = " + var2 + " + " + var3;
-}
-
-bool AddInstruction::checkNumber(const std::string& var)
+void Program::sleep(uint8_t sleepCycles)
 {
-	return !var.empty() && std::all_of(var.begin(), var.end(), std::isdigit);
+	emit(Instruction::InstructionType::SLEEP, 1 << 0, sleepCycles);
 }
 
-void AddInstruction::add()
+size_t Program::size() const
 {
-	if (!process->getSymbolTable().checkVarExists(var1)) {
-		DeclareInstruction decl(process, var1, 0);
-		decl.execute();
-	}
-
-	uint16_t val2 = getValue(var2);
-	uint16_t val3 = getValue(var3);
-
-	uint16_t result = val2 + val3;
-
-	process->getSymbolTable().updateVariable(var1, std::to_string(result));
-
+	return code.size();
 }
 
-/*
-* SUBTRACT INSTRUCTION:
-*/
-
-SubtractInstruction::SubtractInstruction(Process* process, const std::string& var1,
-	const std::string& var2, const std::string& var3)
-	: Instruction(process, InstructionType::SUBTRACT),
-	var1(var1), var2(var2), var3(var3) {
+const Instruction& Program::at(size_t index) const
+{
+	return code[index];
 }
 
-void SubtractInstruction::execute()
+const std::string& Program::text(uint16_t index) const
 {
-	subtract();
+	return strings[index];
 }
 
-uint16_t SubtractInstruction::getValue(const std::string& var)
+size_t Program::variableCount() const
 {
-	//check if the var is a number
-	if (checkNumber(var)) {
-		return static_cast<uint16_t>(std::stoi(var));
-	}
-
-	//if its not a number, and it doesn't exist, declare it as 
-	if (!process->getSymbolTable().checkVarExists(var)) {
-		DeclareInstruction decl(process, var, 0);
-		decl.execute();
-	}
-
-	return static_cast<uint16_t>(std::stoi(process->getSymbolTable().retrieveValue(var)));
+	return variables.size();
 }
 
-bool SubtractInstruction::checkNumber(const std::string& var)
+const std::string& Program::variableName(uint16_t slot) const
 {
-	return !var.empty() && std::all_of(var.begin(), var.end(), std::isdigit);
+	return variables[slot];
 }
 
-void SubtractInstruction::subtract()
+size_t Program::hash() const
 {
-	if (!process->getSymbolTable().checkVarExists(var1)) {
-		DeclareInstruction decl(process, var1, 0);
-		decl.execute();
+	size_t hash = code.size();
+	auto mix = [&hash](size_t value) {
+		hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	};
+	for (const Instruction& instr : code) {
+		mix(static_cast<size_t>(instr.type) | static_cast<size_t>(instr.literals) << 8
+			| static_cast<size_t>(instr.operands[0]) << 16);
+		mix(static_cast<size_t>(instr.operands[1]) | static_cast<size_t>(instr.operands[2]) << 16);
 	}
-
-	uint16_t val2 = getValue(var2);
-	uint16_t val3 = getValue(var3);
-
-	uint16_t result = val2 - val3;
-
-	process->getSymbolTable().updateVariable(var1, std::to_string(result));
-}
-
-std::string SubtractInstruction::getDetails() const {
-	return "SUB " + process->getSymbolTable().retrieveValue(var1) + " = " + var2 + " - " + var3;
+	for (const std::string& text : strings) {
+		mix(std::hash<std::string>()(text));
+	}
+	for (const std::string& name : variables) {
+		mix(std::hash<std::string>()(name));
+	}
+	return hash;
 }
 
-/*
-* SLEEP INSTRUCTION
-*/
-
-SleepInstruction::SleepInstruction(Process* process, std::string sleepCycles)
-	: Instruction(process, Instruction::InstructionType::SLEEP), sleepCycles(sleepCycles) 
+bool Program::operator==(const Program& other) const
 {
+	if (code.size() != other.code.size() || strings != other.strings || variables != other.variables) {
+		return false;
+	}
+	for (size_t i = 0; i < code.size(); ++i) {
+		const Instruction& a = code[i];
+		const Instruction& b = other.code[i];
+		if (a.type != b.type || a.literals != b.literals || a.operands[0] != b.operands[0]
+			|| a.operands[1] != b.operands[1] || a.operands[2] != b.operands[2]) {
+			return false;
+		}
+	}
+	return true;
 }
 
-void SleepInstruction::execute()
+void Program::emit(Instruction::InstructionType type, uint8_t literals, uint16_t a, uint16_t b, uint16_t c)
 {
-	sleep();
+	Instruction instr;
+	instr.type = type;
+	instr.literals = literals;
+	instr.operands[0] = a;
+	instr.operands[1] = b;
+	instr.operands[2] = c;
+	code.push_back(instr);
 }
 
-void SleepInstruction::sleep()
+// Literals wrap to uint16 the way the stored value always has
+uint16_t Program::operand(const std::string& text, int index, uint8_t& literals)
 {
-	uint8_t sC = static_cast<uint8_t>(std::stoi(sleepCycles));
-	process->setSleeping(true, sC);
-}
-
-std::string SleepInstruction::getDetails() const {
-	return "[INITIALIZE] SLEEP for " + std::to_string(process->getRemainingSleepCycles()) + " cycles";
-}
+	bool isNumber = !text.empty() && std::all_of(text.begin(), text.end(),
+		[](unsigned char c) { return std::isdigit(c) != 0; });
+	if (!isNumber) {
+		return intern(variables, text);
+	}
 
-/*
-* FOR INSTRUCTION
-*/
-ForInstruction::ForInstruction(Process* process, std::vector<Instruction> instructionList, int repeats) 
-	: Instruction(process, Instruction::InstructionType::FOR), repeats(repeats)
-{
+	uint16_t value = 0;
+	for (char digit : text) {
+		value = static_cast<uint16_t>(value * 10 + (digit - '0'));
+	}
+	literals |= 1 << index;
+	return value;
 }
 
-void ForInstruction::execute()
+// Programs only use a handful of distinct names, so a scan beats a map
+uint16_t Program::intern(std::vector<std::string>& pool, const std::string& text)
 {
-	if (repeats <= 3) {
-
+	auto it = std::find(pool.begin(), pool.end(), text);
+	if (it != pool.end()) {
+		return static_cast<uint16_t>(it - pool.begin());
 	}
+	if (pool.size() > std::numeric_limits<uint16_t>::max()) {
+		throw std::length_error("Program has too many distinct operands");
+	}
+	pool.push_back(text);
+	return static_cast<uint16_t>(pool.size() - 1);
 }
-
-
-
-
-
@@ -1,15 +1,15 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
-#include <sstream>
-#include <algorithm>
-#include <memory>
 
-class Process;
-
-class Instruction {
-public:
-    enum class InstructionType {
+// One instruction as a fixed 8-byte record. Variables are register slots
+// and literals are stored parsed; bit i of literals marks operand i as a
+// literal. PRINT's first operand indexes the program's text pool; its second,
+// if set, appends the running process's name.
+struct Instruction {
+    enum class InstructionType : uint8_t {
         PRINT,
         DECLARE,
         ADD,
@@ -18,91 +18,46 @@ public:
         FOR
     };
 
-    Instruction(Process* process, InstructionType instructionType);
-    virtual ~Instruction() = default;
-
-    InstructionType getInstructionType();
-    virtual void execute();
-    virtual std::string getDetails() const = 0;
-
-
-protected:
-    Process* process;
-    InstructionType instructionType;
-    std::vector<std::string> args;              
-    std::vector<Instruction> body;              
-    int repeatCount = 0;                        
-};
-
-class PrintInstruction : public Instruction {
-public:
-    PrintInstruction(Process* process, const std::string& toPrint);  
-    void execute() override;
-    std::string getDetails() const override;
-
-private:
-    std::string toPrint;
-};
-
-class DeclareInstruction : public Instruction {
-public:
-    DeclareInstruction(Process* process, const std::string& varName, uint16_t value);
-    void execute() override;
-    std::string getDetails() const override;  
-    bool performDeclaration();
+    InstructionType type;
+    uint8_t literals;
+    uint16_t operands[3];
 
-private:
-    std::string varName;
-    uint16_t value;  
+    bool isLiteral(int operand) const { return (literals >> operand) & 1; }
 };
 
-class AddInstruction : public Instruction {
+// Instructions in one contiguous array. Operands are compiled as they are
+// added: literals are parsed once and each variable name gets a dense slot,
+// so running the program never touches a string. Once built, a program is
+// shared read-only by every process that runs it; the processes keep their
+// own position and registers.
+class Program {
 public:
-    AddInstruction(Process* process, const std::string& var1,
-        const std::string& var2, const std::string& var3);
-    void execute() override;
-    std::string getDetails() const override;
-    void add();
+    // One shared copy per distinct program, found by content hash. A program
+    // is dropped once the last process running it lets go.
+    static std::shared_ptr<const Program> share(Program program);
 
-private:
-    std::string var1;
-    std::string var2;
-    std::string var3;
+    void print(const std::string& toPrint, bool withProcessName = false);
+    void declare(const std::string& varName, uint16_t value);
+    void add(const std::string& var1, const std::string& var2, const std::string& var3);
+    void subtract(const std::string& var1, const std::string& var2, const std::string& var3);
+    void sleep(uint8_t sleepCycles);
 
-    uint16_t getValue(const std::string& var);
-    bool checkNumber(const std::string& s);
-};
+    size_t size() const;
+    const Instruction& at(size_t index) const;
+    const std::string& text(uint16_t index) const;
+    size_t variableCount() const;
+    const std::string& variableName(uint16_t slot) const;
 
-class SubtractInstruction : public Instruction {
-public:
-    SubtractInstruction(Process* process, const std::string& var1, const std::string& var2, const std::string& var3);
-    void execute() override;
-    uint16_t getValue(const std::string& var);
-    bool checkNumber(const std::string& var);
-    std::string getDetails() const override;
-    void subtract();
-private:
-    std::string var1;
-    std::string var2;
-    std::string var3;
-};
-
-class SleepInstruction : public Instruction {
-public:
-    SleepInstruction(Process* process, std::string sleepCycles);
-    void execute() override;
-    void sleep();
-    std::string getDetails() const override;
+    size_t hash() const;
+    bool operator==(const Program& other) const;
 
 private:
-    std::string sleepCycles;
+    void emit(Instruction::InstructionType type, uint8_t literals, uint16_t a, uint16_t b = 0, uint16_t c = 0);
+    // Sets the operand's literal bit if it is all digits, else gives its slot
+    uint16_t operand(const std::string& text, int index, uint8_t& literals);
+    static uint16_t intern(std::vector<std::string>& pool, const std::string& text);
+
+    std::vector<Instruction> code;
+    std::vector<std::string> strings;
+    std::vector<std::string> variables;  // slot -> name
 };
-
-class ForInstruction : public Instruction {
-public:
-    ForInstruction(Process* process, std::vector<Instruction> instructionList, int repeats);
-    void execute() override;
-private:
-    std::vector<Instruction> instructionList;
-    int repeats;
-};
\ No newline at end of file
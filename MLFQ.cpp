@@ -0,0 +1,79 @@
+#include "MLFQ.h"
+
+MLFQScheduler::MLFQScheduler(int numCores, const std::vector<unsigned>& levelQuanta, uint64_t boostPeriod,
+    int delays_per_exec, size_t maxMemory, size_t frameSize)
+    : QueueScheduler(numCores, delays_per_exec, maxMemory, frameSize),
+    levelQuanta(levelQuanta),
+    levels(levelQuanta.size()),
+    boostPeriod(boostPeriod) {
+}
+
+MLFQScheduler::~MLFQScheduler() {
+    stop();
+}
+
+void MLFQScheduler::pushReady(std::shared_ptr<Process> process) {
+    auto it = processLevel.find(process->getId());
+    int level = (it != processLevel.end()) ? it->second : 0;
+    levels[level].push_back(process);
+    queuedCount++;
+}
+
+std::shared_ptr<Process> MLFQScheduler::popReady() {
+    boostIfDue();
+
+    for (auto& level : levels) {
+        if (!level.empty()) {
+            auto process = level.front();
+            level.pop_front();
+            queuedCount--;
+            return process;
+        }
+    }
+    return nullptr;
+}
+
+size_t MLFQScheduler::readyCount() const {
+    return queuedCount;
+}
+
+unsigned MLFQScheduler::quantumFor(const std::shared_ptr<Process>& process) {
+    auto it = processLevel.find(process->getId());
+    return levelQuanta[(it != processLevel.end()) ? it->second : 0];
+}
+
+void MLFQScheduler::requeue(std::shared_ptr<Process> process, unsigned cyclesUsed) {
+    int& level = processLevel[process->getId()];
+    // Only a process that used its whole quantum is treated as CPU-bound
+    if (cyclesUsed >= levelQuanta[level] && level + 1 < static_cast<int>(levels.size())) {
+        level++;
+    }
+    pushReady(process);
+}
+
+void MLFQScheduler::retire(const std::shared_ptr<Process>& process) {
+    processLevel.erase(process->getId());
+}
+
+// Lifts every queued process back to the top level. Processes that are running
+// or asleep lose their level too, so they re-enter at the top.
+void MLFQScheduler::boostIfDue() {
+    uint64_t now = clock->getTick();
+    if (boostPeriod == 0 || now - lastBoost < boostPeriod) return;
+    lastBoost = now;
+
+    for (size_t i = 1; i < levels.size(); ++i) {
+        for (auto& process : levels[i]) {
+            levels[0].push_back(process);
+        }
+        levels[i].clear();
+    }
+    processLevel.clear();
+}
+
+void MLFQScheduler::describeQueues(std::vector<std::string>& lines) {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        lines.push_back("MLFQ level " + std::to_string(i) + " (quantum " +
+            std::to_string(levelQuanta[i]) + "): " + std::to_string(levels[i].size()) + " ready");
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "QueueScheduler.h"
+#include <deque>
+#include <unordered_map>
+
+// Multi-level feedback queue: new and woken processes enter at their current
+// level (0 at first), using a whole quantum demotes one level, and every
+// boostPeriod ticks everything is lifted back to level 0.
+class MLFQScheduler : public QueueScheduler<MLFQScheduler> {
+public:
+    MLFQScheduler(int numCores, const std::vector<unsigned>& levelQuanta, uint64_t boostPeriod,
+        int delays_per_exec, size_t maxMemory, size_t frameSize);
+    ~MLFQScheduler() override;
+
+protected:
+    friend class QueueScheduler<MLFQScheduler>;
+    void pushReady(std::shared_ptr<Process> process);
+    std::shared_ptr<Process> popReady();
+    size_t readyCount() const;
+    unsigned quantumFor(const std::shared_ptr<Process>& process);
+    void requeue(std::shared_ptr<Process> process, unsigned cyclesUsed);
+    void retire(const std::shared_ptr<Process>& process);
+    void describeQueues(std::vector<std::string>& lines) override;
+
+private:
+    void boostIfDue();
+
+    std::vector<unsigned> levelQuanta;
+    std::vector<std::deque<std::shared_ptr<Process>>> levels;
+    std::unordered_map<int, int> processLevel;
+    uint64_t boostPeriod;
+    uint64_t lastBoost = 0;
+    size_t queuedCount = 0;
+};
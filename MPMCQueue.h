@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+#include "CacheAligned.h"
+
+// Bounded lock-free multi-producer/multi-consumer FIFO (Vyukov's ring). Each
+// cell carries a sequence number saying whether it is ready to be written or
+// read at a given position, so producers and consumers only contend on the
+// position they claim with a CAS. Capacity is rounded up to a power of two.
+template <typename T>
+class MPMCQueue {
+public:
+    explicit MPMCQueue(size_t capacity = 0) {
+        resize(capacity);
+    }
+
+    // Not thread-safe; call before the queue is shared
+    void resize(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueueCursor.position.store(0, std::memory_order_relaxed);
+        dequeueCursor.position.store(0, std::memory_order_relaxed);
+    }
+
+    // The value is only moved from if the push succeeds
+    template <typename U>
+    bool tryPush(U&& value) {
+        size_t position = enqueueCursor.position.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (lag == 0) {
+                if (enqueueCursor.position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::forward<U>(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lag < 0) {
+                return false;  // full
+            }
+            else {
+                position = enqueueCursor.position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value) {
+        size_t position = dequeueCursor.position.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (lag == 0) {
+                if (dequeueCursor.position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.value = T();
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lag < 0) {
+                return false;  // empty
+            }
+            else {
+                position = dequeueCursor.position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Fallback when full: spin briefly, then yield, then sleep, so a producer
+    // that outruns the consumers backs off instead of holding its host thread hot
+    template <typename U>
+    void push(U&& value) {
+        for (unsigned attempt = 0; !tryPush(std::forward<U>(value)); ++attempt) {
+            if (attempt < 64) continue;
+            if (attempt < 128) {
+                std::this_thread::yield();
+            }
+            else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+    // Exact when no push or pop is in flight
+    size_t sizeApprox() const {
+        size_t tail = enqueueCursor.position.load(std::memory_order_relaxed);
+        size_t head = dequeueCursor.position.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{ 0 };
+        T value{};
+    };
+
+    // Producers and consumers advance different cursors; keep them on
+    // separate cache lines
+    struct Cursor : CacheAligned {
+        std::atomic<size_t> position{ 0 };
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    Cursor enqueueCursor;
+    Cursor dequeueCursor;
+};
@@ -13,7 +13,40 @@ MemoryManager::MemoryManager(size_t maxMemory, size_t frameSize)
 
 bool MemoryManager::allocateMemory(int processId, size_t memoryNeeded) {
     std::lock_guard<std::mutex> lock(memoryMutex);
+    return allocateLocked(processId, memoryNeeded);
+}
+
+bool MemoryManager::allocateOrWait(int processId, size_t memoryNeeded, std::function<void()> onAdmitted) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    for (const auto& block : memoryBlocks) {
+        if (block.allocated && block.processId == processId) {
+            return true;
+        }
+    }
+    if (allocateLocked(processId, memoryNeeded)) {
+        return true;
+    }
+    if (memoryNeeded <= maxMemory) {
+        waiters.emplace(memoryNeeded, Waiter{ processId, std::move(onAdmitted) });
+    }
+    return false;
+}
 
+bool MemoryManager::canEverFit(size_t memoryNeeded) const {
+    return memoryNeeded <= maxMemory;
+}
+
+size_t MemoryManager::getMaxMemory() const {
+    return maxMemory;
+}
+
+size_t MemoryManager::waitingCount() const {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    return waiters.size();
+}
+
+// Must hold memoryMutex
+bool MemoryManager::allocateLocked(int processId, size_t memoryNeeded) {
     // Prevent allocating again if already allocated
     for (const auto& block : memoryBlocks) {
         if (block.allocated && block.processId == processId) {
@@ -60,7 +93,8 @@ bool MemoryManager::allocateMemory(int processId, size_t memoryNeeded) {
 
 
 void MemoryManager::deallocateMemory(int processId) {
-    std::lock_guard<std::mutex> lock(memoryMutex);
+    std::vector<std::function<void()>> admitted;
+    std::unique_lock<std::mutex> lock(memoryMutex);
     for (auto it = memoryBlocks.begin(); it != memoryBlocks.end(); ++it) {
         if (it->allocated && it->processId == processId) {
             it->allocated = false;
@@ -85,6 +119,20 @@ void MemoryManager::deallocateMemory(int processId) {
             break;
         }
     }
+
+    // Allocation is first fit, so once the smallest waiter does not fit,
+    // no larger one can
+    while (!waiters.empty()) {
+        auto smallest = waiters.begin();
+        if (!allocateLocked(smallest->second.processId, smallest->first)) break;
+        admitted.push_back(std::move(smallest->second.onAdmitted));
+        waiters.erase(smallest);
+    }
+    lock.unlock();
+
+    for (auto& onAdmitted : admitted) {
+        onAdmitted();
+    }
 }
 
 size_t MemoryManager::calculateFragmentation() const {
@@ -3,13 +3,24 @@
 #include <vector>
 #include <string>
 #include <mutex>
+#include <map>
+#include <functional>
 
 class MemoryManager {
 public:
     MemoryManager(size_t maxMemory, size_t frameSize);
 
     bool allocateMemory(int processId, size_t memoryNeeded);
+    // Allocates now if the process fits, otherwise queues the request. Each
+    // deallocation grants queued requests smallest first, for as long as they
+    // fit, and calls onAdmitted (outside the lock) for each one granted.
+    // A request larger than the whole memory is never queued; it could
+    // only ever wait.
+    bool allocateOrWait(int processId, size_t memoryNeeded, std::function<void()> onAdmitted);
+    bool canEverFit(size_t memoryNeeded) const;
+    size_t getMaxMemory() const;
     void deallocateMemory(int processId);
+    size_t waitingCount() const;
     void generateMemorySnapshot(const std::string& filename, int quantumCycle) const;
     bool isInMemory(int pid) const;
 
@@ -27,5 +38,12 @@ private:
     std::vector<MemoryBlock> memoryBlocks;
     mutable std::mutex memoryMutex;
 
+    struct Waiter {
+        int processId;
+        std::function<void()> onAdmitted;
+    };
+    std::multimap<size_t, Waiter> waiters;  // by size, then arrival
+
+    bool allocateLocked(int processId, size_t memoryNeeded);
     size_t calculateFragmentation() const;
 };
\ No newline at end of file
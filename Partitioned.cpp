@@ -0,0 +1,101 @@
+#include "Partitioned.h"
+
+PartitionedScheduler::PartitionedScheduler(std::vector<Partition> partitions, size_t longJobInstructions,
+    size_t maxMemory, size_t frameSize)
+    : Scheduler(totalCores(partitions), maxMemory, frameSize, 0),
+    partitions(std::move(partitions)),
+    longJobInstructions(longJobInstructions) {
+    for (auto& partition : this->partitions) {
+        partition.scheduler->shareResources(*this);
+        partition.scheduler->setCoreBase(partition.firstCore);
+    }
+}
+
+PartitionedScheduler::~PartitionedScheduler() {
+    stop();
+}
+
+int PartitionedScheduler::totalCores(const std::vector<Partition>& partitions) {
+    int cores = 0;
+    for (const auto& partition : partitions) {
+        cores += partition.coreCount;
+    }
+    return cores;
+}
+
+// The partitions own every core; this scheduler only starts the host pool
+// they share
+void PartitionedScheduler::start() {
+    if (!running) {
+        running = true;
+        startHostPool();
+        for (auto& partition : partitions) {
+            partition.scheduler->start();
+        }
+    }
+}
+
+void PartitionedScheduler::stop() {
+    for (auto& partition : partitions) {
+        partition.scheduler->stop();
+    }
+    Scheduler::stop();
+}
+
+// Round-robin over the partitions of the job's class, falling back to "any"
+// partitions and then to every partition
+PartitionedScheduler::Partition& PartitionedScheduler::classify(const std::shared_ptr<Process>& process) {
+    bool isLong = process->getInstructionCount() >= longJobInstructions;
+    const std::string jobClass = isLong ? "long" : "short";
+    unsigned turn = isLong ? nextLong++ : nextShort++;
+
+    for (const std::string& accepted : { jobClass, std::string("any") }) {
+        std::vector<Partition*> candidates;
+        for (auto& partition : partitions) {
+            if (partition.jobClass == accepted) {
+                candidates.push_back(&partition);
+            }
+        }
+        if (!candidates.empty()) {
+            return *candidates[turn % candidates.size()];
+        }
+    }
+    return partitions[turn % partitions.size()];
+}
+
+void PartitionedScheduler::addProcess(std::shared_ptr<Process> process) {
+    classify(process).scheduler->addProcess(process);
+}
+
+std::string PartitionedScheduler::partitionLabel(const Partition& partition) const {
+    return "Partition cores " + std::to_string(partition.firstCore) + "-" +
+        std::to_string(partition.firstCore + partition.coreCount - 1) +
+        " (" + partition.policy + ", " + partition.jobClass + " jobs)";
+}
+
+void PartitionedScheduler::appendProcessStatus(std::vector<std::string>& lines) {
+    int coresUsed = 0;
+    for (auto& partition : partitions) {
+        coresUsed += partition.scheduler->countBusyCores();
+    }
+    int cpuUtilization = static_cast<int>((static_cast<float>(coresUsed) / numCores) * 100);
+
+    lines.push_back("CPU utilization: " + std::to_string(cpuUtilization) + "%");
+    lines.push_back("Cores used: " + std::to_string(coresUsed));
+    lines.push_back("Cores available: " + std::to_string(numCores - coresUsed));
+
+    for (auto& partition : partitions) {
+        lines.push_back("\n--- " + partitionLabel(partition) + " ---");
+        partition.scheduler->appendProcessStatus(lines);
+    }
+}
+
+void PartitionedScheduler::describeReport(std::vector<std::string>& lines) {
+    for (auto& partition : partitions) {
+        auto partitionLines = partition.scheduler->buildReportExtras();
+        if (partitionLines.empty()) continue;
+
+        lines.push_back(partitionLabel(partition) + ":");
+        lines.insert(lines.end(), partitionLines.begin(), partitionLines.end());
+    }
+}
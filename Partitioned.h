@@ -0,0 +1,44 @@
+#pragma once
+#include "Scheduler.h"
+#include <string>
+
+// Splits the cores into partitions that each run their own scheduler on a
+// shared clock and shared memory. Arrivals are routed by a classifier: jobs
+// of at least longJobInstructions go to "long" partitions, the rest to
+// "short" ones, and "any" partitions take either.
+class PartitionedScheduler : public Scheduler {
+public:
+    struct Partition {
+        int firstCore;
+        int coreCount;
+        std::string policy;
+        std::string jobClass;  // "long", "short" or "any"
+        std::unique_ptr<Scheduler> scheduler;
+    };
+
+    PartitionedScheduler(std::vector<Partition> partitions, size_t longJobInstructions,
+        size_t maxMemory, size_t frameSize);
+    ~PartitionedScheduler() override;
+
+    void start() override;
+    void stop() override;
+    void addProcess(std::shared_ptr<Process> process) override;
+    void appendProcessStatus(std::vector<std::string>& lines) override;
+    // Partitions are sized by the partitions setting
+    bool setActiveCores(int cores) override { return false; }
+
+protected:
+    void describeReport(std::vector<std::string>& lines) override;
+
+private:
+    static int totalCores(const std::vector<Partition>& partitions);
+    std::string partitionLabel(const Partition& partition) const;
+    Partition& classify(const std::shared_ptr<Process>& process);
+
+    void runCore(int coreId) override {}
+
+    std::vector<Partition> partitions;
+    size_t longJobInstructions;
+    std::atomic<unsigned> nextLong{ 0 };
+    std::atomic<unsigned> nextShort{ 0 };
+};
@@ -1,10 +1,12 @@
 #include "Process.h"
 #include "Instruction.h"
 #include <iostream>
+#include <cassert>
 
 std::mutex Process::fileMutex;
 
-Process::Process(const std::string& name, int id, size_t memoryRequired) : name(name), id(id), memoryRequired(memoryRequired) {
+Process::Process(const std::string& name, int id, size_t memoryRequired)
+    : name(name), id(id), memoryRequired(memoryRequired), stateWord(pack(ProcessState::New, -1)) {
     time_t now = time(nullptr);
     tm local;
     localtime_s(&local, &now);
@@ -20,6 +22,9 @@ Process::Process(const std::string& name, int id, size_t memoryRequired) : name(
 }
 
 Process::~Process() {
+    if (stateCounts) {
+        (*stateCounts)[static_cast<int>(getState())]--;
+    }
     std::lock_guard<std::mutex> lock(fileMutex);
     if (logFile.is_open()) {
         logFile.flush();  
@@ -43,39 +48,85 @@ void Process::assignPages(const std::vector<int>& pages) {
 }
 
 bool Process::executeNextInstruction() {
+    int index = currentInstruction.load(std::memory_order_relaxed);
+    if (index < static_cast<int>(getInstructionCount())) {
+
+        const Instruction& instr = program->at(index);
+        currentInstruction.store(index + 1, std::memory_order_relaxed);
+
+        switch (instr.type) {
+        case Instruction::InstructionType::DECLARE:
+            if (!declared[instr.operands[0]].load(std::memory_order_relaxed)) {
+                writeRegister(instr.operands[0], instr.operands[1]);
+            }
+            break;
+        case Instruction::InstructionType::ADD:
+            writeRegister(instr.operands[0], static_cast<uint16_t>(operandValue(instr, 1) + operandValue(instr, 2)));
+            break;
+        case Instruction::InstructionType::SUBTRACT:
+            writeRegister(instr.operands[0], static_cast<uint16_t>(operandValue(instr, 1) - operandValue(instr, 2)));
+            break;
+        case Instruction::InstructionType::SLEEP:
+            setSleeping(true, static_cast<uint8_t>(instr.operands[0]));
+            break;
+        default:
+            break;
+        }
 
-    // if the process is sleeping, will countdown the sleep cycles until it wakes up
-    if (isSleeping) {
-        logInstruction("SLEEP", "SLEEP FOR " + std::to_string(remainingSleepCycles) + " CYCLES");
-        remainingSleepCycles--;
+        logInstruction(instructionTypeToString(instr.type), describe(instr));
 
-        if (remainingSleepCycles <= 0) {
-            isSleeping = false;
-        }
+        return true;
+    }
 
+    if (index >= static_cast<int>(getInstructionCount())) {
+        moveTo(ProcessState::Finished);
         return false;
     }
 
-    if (currentInstruction < static_cast<int>(instructionList.size())) {
+    return true;
+}
 
-        auto instr = instructionList[currentInstruction++];
+uint16_t Process::readRegister(uint16_t slot) const {
+    return registers[slot].load(std::memory_order_relaxed);
+}
 
-        instr->execute();
+void Process::writeRegister(uint16_t slot, uint16_t value) {
+    registers[slot].store(value, std::memory_order_relaxed);
+    declared[slot].store(true, std::memory_order_relaxed);
+}
 
-        logInstruction(
-            instructionTypeToString(instr->getInstructionType()),
-            instr->getDetails()
-        );
+// A variable read before it is declared is declared as 0
+uint16_t Process::operandValue(const Instruction& instr, int operand) {
+    uint16_t value = instr.operands[operand];
+    if (instr.isLiteral(operand)) return value;
+    declared[value].store(true, std::memory_order_relaxed);
+    return readRegister(value);
+}
 
-        return true;
-    }
+std::string Process::operandText(const Instruction& instr, int operand) const {
+    if (instr.isLiteral(operand)) return std::to_string(instr.operands[operand]);
+    return program->variableName(instr.operands[operand]);
+}
 
-    if (currentInstruction >= static_cast<int>(instructionList.size())) {
-        isFinished = true;
-        return false;
+// Log text for an instruction that has just run
+std::string Process::describe(const Instruction& instr) const {
+    switch (instr.type) {
+    case Instruction::InstructionType::PRINT:
+        return "Message: " + program->text(instr.operands[0]) + (instr.operands[1] ? name : "");
+    case Instruction::InstructionType::DECLARE:
+        return "Declared variable: " + program->variableName(instr.operands[0])
+            + " with value: " + std::to_string(readRegister(instr.operands[0]));
+    case Instruction::InstructionType::ADD:
+        return "ADD " + std::to_string(readRegister(instr.operands[0])) + " = "
+            + operandText(instr, 1) + " + " + operandText(instr, 2);
+    case Instruction::InstructionType::SUBTRACT:
+        return "SUB " + std::to_string(readRegister(instr.operands[0])) + " = "
+            + operandText(instr, 1) + " - " + operandText(instr, 2);
+    case Instruction::InstructionType::SLEEP:
+        return "[INITIALIZE] SLEEP for " + std::to_string(remainingSleepCycles) + " cycles";
+    default:
+        return "";
     }
-
-    return true;
 }
 
 
@@ -89,15 +140,19 @@ void Process::logInstruction(const std::string& type, const std::string& details
         ss << std::put_time(&local, "%m/%d/%Y %I:%M:%S%p");
 
         std::lock_guard<std::mutex> lock(fileMutex);
-        logFile << "(" << ss.str() << ") Core:" << assignedCore
+        logFile << "(" << ss.str() << ") Core:" << getAssignedCore()
             << " \"" << details << "\"\n";
         logFile.flush();
    // }
 
 }
 
-void Process::addInstruction(std::shared_ptr<Instruction> instruction) {
-    instructionList.push_back(instruction);
+// The program may be shared; the registers are this process's own
+void Process::loadProgram(std::shared_ptr<const Program> program) {
+    this->program = std::move(program);
+    size_t slots = this->program->variableCount();
+    registers.reset(new std::atomic<uint16_t>[slots]());
+    declared.reset(new std::atomic<bool>[slots]());
 }
 
 std::vector<std::string> Process::getLogs() const {
@@ -131,6 +186,19 @@ std::string Process::instructionTypeToString(Instruction::InstructionType type)
     }
 }
 
+const char* Process::stateName(ProcessState state) {
+    switch (state) {
+    case ProcessState::New:           return "new";
+    case ProcessState::Ready:         return "ready";
+    case ProcessState::Running:       return "running";
+    case ProcessState::Sleeping:      return "sleeping";
+    case ProcessState::WaitingMemory: return "waiting-memory";
+    case ProcessState::Finished:      return "finished";
+    case ProcessState::Rejected:      return "rejected";
+    default: return "unknown";
+    }
+}
+
 size_t Process::getMemoryNeeded() const {
     return memoryRequired;
 }
@@ -139,36 +207,155 @@ int Process::getId() const {
     return id;
 }
 
+uint64_t Process::pack(ProcessState state, int core)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(core)) << 8) | static_cast<uint8_t>(state);
+}
+
+ProcessState Process::stateOf(uint64_t word)
+{
+    return static_cast<ProcessState>(word & 0xff);
+}
+
+int Process::coreOf(uint64_t word)
+{
+    return static_cast<int>(static_cast<uint32_t>(word >> 8));
+}
+
+// Per-state counts follow every successful swap, so they are only ever off
+// by the transitions in flight
+bool Process::swapState(uint64_t& expected, uint64_t desired)
+{
+    if (!stateWord.compare_exchange_weak(expected, desired)) return false;
+    if (stateCounts && stateOf(expected) != stateOf(desired)) {
+        (*stateCounts)[static_cast<int>(stateOf(expected))]--;
+        (*stateCounts)[static_cast<int>(stateOf(desired))]++;
+    }
+    return true;
+}
+
+void Process::attachStateCounts(std::shared_ptr<StateCounts> counts)
+{
+    if (stateCounts) return;
+    stateCounts = std::move(counts);
+    (*stateCounts)[static_cast<int>(getState())]++;
+}
+
+bool Process::transition(ProcessState from, ProcessState to)
+{
+    uint64_t word = stateWord.load();
+    while (stateOf(word) == from) {
+        if (swapState(word, pack(to, coreOf(word)))) return true;
+    }
+    return false;
+}
+
+bool Process::transition(ProcessState from, ProcessState to, int core)
+{
+    uint64_t word = stateWord.load();
+    while (stateOf(word) == from) {
+        if (swapState(word, pack(to, core))) return true;
+    }
+    return false;
+}
+
+void Process::mustTransition(ProcessState from, ProcessState to)
+{
+    if (!transition(from, to)) reportFailedTransition(from, to);
+}
+
+void Process::mustTransition(ProcessState from, ProcessState to, int core)
+{
+    if (!transition(from, to, core)) reportFailedTransition(from, to);
+}
+
+void Process::reportFailedTransition(ProcessState from, ProcessState to)
+{
+    logInstruction("STATE", std::string("Expected ") + stateName(from) + " -> " + stateName(to)
+        + " but the process was " + stateName(getState()));
+    assert(!"process state transition failed");
+}
+
+bool Process::reject(const std::string& reason)
+{
+    if (!transition(ProcessState::New, ProcessState::Rejected)) return false;
+    rejectionReason = reason;
+    logInstruction("REJECTED", "Rejected: " + reason);
+    return true;
+}
+
+const std::string& Process::getRejectionReason() const
+{
+    return rejectionReason;
+}
+
+// Any state may move to the target except FINISHED, which is final
+void Process::moveTo(ProcessState to)
+{
+    uint64_t word = stateWord.load();
+    while (stateOf(word) != ProcessState::Finished) {
+        if (swapState(word, pack(to, coreOf(word)))) return;
+    }
+}
+
 void Process::setAssignedCore(int core)
 {
-    assignedCore = core;
+    uint64_t word = stateWord.load();
+    while (!swapState(word, pack(stateOf(word), core))) {
+    }
 }
 
 void Process::setSleeping(bool isSleeping, uint8_t sleepCycles)
 {
-    this->isSleeping = isSleeping;
     this->remainingSleepCycles = sleepCycles;
+    if (isSleeping) {
+        moveTo(ProcessState::Sleeping);
+    }
+    else {
+        mustTransition(ProcessState::Sleeping, ProcessState::Ready);
+    }
 }
 
 void Process::setIsFinished(bool isFinished)
 {
-    std::lock_guard<std::mutex> lock(stateMutex);
-    this->isFinished = isFinished;
+    if (isFinished) {
+        moveTo(ProcessState::Finished);
+    }
+}
+
+void Process::setDeadline(uint64_t deadline)
+{
+    this->deadline = deadline;
+}
+
+void Process::setTickets(int tickets)
+{
+    this->tickets = std::max(1, tickets);
+}
+
+void Process::setLastCore(int core)
+{
+    lastCore = core;
 }
 
 int Process::getAssignedCore() const
 {
-    return assignedCore;
+    return coreOf(stateWord.load());
+}
+
+ProcessState Process::getState() const
+{
+    return stateOf(stateWord.load());
 }
 
 int Process::getCurrentInstructionIndex() const
 {
-    return currentInstruction;
+    return currentInstruction.load(std::memory_order_relaxed);
 }
 
 size_t Process::getInstructionCount() const
 {
-    return instructionList.size();
+    return program ? program->size() : 0;
 }
 
 void Process::setMaxExecutionDelay(int delay)
@@ -176,13 +363,16 @@ void Process::setMaxExecutionDelay(int delay)
     maxExecDelay = std::max(0, delay);
 }
 
-size_t Process::getMemoryNeeded() const 
-{ 
-    return memoryRequired; 
-}
-
-SymbolTable& Process::getSymbolTable()
+// Built from the registers on request, for process-smi; execution never
+// goes through it. A running process may be a few instructions ahead.
+SymbolTable Process::getSymbolTable() const
 {
+    SymbolTable symbolTable;
+    size_t slots = program ? program->variableCount() : 0;
+    for (size_t slot = 0; slot < slots; ++slot) {
+        if (!declared[slot].load(std::memory_order_relaxed)) continue;
+        symbolTable.insertVariable(program->variableName(static_cast<uint16_t>(slot)), readRegister(static_cast<uint16_t>(slot)));
+    }
     return symbolTable;
 }
 
@@ -195,11 +385,11 @@ std::string Process::getCreationTime() const {
 }
 
 int Process::getIsSleeping() const {
-    return isSleeping;
+    return getState() == ProcessState::Sleeping;
 }
 
 int Process::getIsFinished() const {
-    return isFinished;
+    return getState() == ProcessState::Finished;
 }
 
 int Process::getRemainingSleepCycles() const
@@ -207,6 +397,26 @@ int Process::getRemainingSleepCycles() const
     return remainingSleepCycles;
 }
 
+bool Process::hasDeadline() const
+{
+    return deadline != 0;
+}
+
+uint64_t Process::getDeadline() const
+{
+    return deadline;
+}
+
+int Process::getTickets() const
+{
+    return tickets;
+}
+
+int Process::getLastCore() const
+{
+    return lastCore;
+}
+
 const std::vector<int>& Process::getAssignedPages() const
 {
     return assignedPages;
@@ -5,19 +5,36 @@
 #include <iomanip>
 #include <sstream>
 #include <mutex>
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
+#include <array>
 #include "Instruction.h"
 #include "SymbolTable.h"
 
+enum class ProcessState : uint8_t {
+    New,
+    Ready,
+    Running,
+    Sleeping,
+    WaitingMemory,
+    Finished,
+    Rejected,  // turned away on arrival; never runs
+    Count
+};
+
+// How many of a scheduler's processes are in each state
+using StateCounts = std::array<std::atomic<int>, static_cast<int>(ProcessState::Count)>;
+
 class Process {
 public:
     Process(const std::string& name, int id, size_t memoryRequired);
     ~Process();
 
     bool executeNextInstruction();
-    void addInstruction(std::shared_ptr<Instruction> instruction);
+    void loadProgram(std::shared_ptr<const Program> program);
 
     std::vector<std::string> getLogs() const;
     void logInstruction(const std::string& type, const std::string& details);
@@ -28,8 +45,26 @@ public:
     void setAssignedCore(int core);
     void setSleeping(bool isSleeping, uint8_t sleepCycles);
     void setIsFinished(bool isFinished);
+    void setDeadline(uint64_t deadline);
+    void setTickets(int tickets);
+    void setLastCore(int core);
+
+    // Turns a new process away for good; the reason goes to its log and is
+    // kept for the console
+    bool reject(const std::string& reason);
+    const std::string& getRejectionReason() const;
 
-    SymbolTable& getSymbolTable();
+    bool transition(ProcessState from, ProcessState to);
+    bool transition(ProcessState from, ProcessState to, int core);
+    // For transitions the scheduler relies on; a failure is a state bug, so
+    // it is logged and asserts in debug builds
+    void mustTransition(ProcessState from, ProcessState to);
+    void mustTransition(ProcessState from, ProcessState to, int core);
+    // The process is counted from here on; later calls are ignored
+    void attachStateCounts(std::shared_ptr<StateCounts> counts);
+    ProcessState getState() const;
+
+    SymbolTable getSymbolTable() const;
     std::string getName() const;
     std::string getCreationTime() const;
     int getId() const;
@@ -41,14 +76,22 @@ public:
     int getIsSleeping() const;
     int getIsFinished() const;
     int getRemainingSleepCycles() const;
+    bool hasDeadline() const;
+    uint64_t getDeadline() const;
+    int getTickets() const;
+    int getLastCore() const;
     const std::vector<int>& getAssignedPages() const;
 
     static std::string instructionTypeToString(Instruction::InstructionType type);
+    static const char* stateName(ProcessState state);
 
 
 private:
-    SymbolTable symbolTable;
-    std::vector<std::shared_ptr<Instruction>> instructionList;
+    std::shared_ptr<const Program> program;
+    // One per program variable slot. Only the running core writes them, but
+    // process-smi reads them from the console, so they are relaxed atomics.
+    std::unique_ptr<std::atomic<uint16_t>[]> registers;
+    std::unique_ptr<std::atomic<bool>[]> declared;
     std::vector<int> assignedPages;
     
     std::string name;
@@ -57,17 +100,40 @@ private:
     std::ofstream logFile;
     size_t memoryRequired;
 
-    int assignedCore = -1;
-    int currentInstruction = 0;
+    void moveTo(ProcessState to);
+
+    uint16_t readRegister(uint16_t slot) const;
+    void writeRegister(uint16_t slot, uint16_t value);
+    uint16_t operandValue(const Instruction& instr, int operand);
+    std::string operandText(const Instruction& instr, int operand) const;
+    std::string describe(const Instruction& instr) const;
+
+    // State in the low byte, assigned core above it, so both change in one CAS
+    static uint64_t pack(ProcessState state, int core);
+    static ProcessState stateOf(uint64_t word);
+    static int coreOf(uint64_t word);
+    bool swapState(uint64_t& expected, uint64_t desired);
+    void reportFailedTransition(ProcessState from, ProcessState to);
+
+    std::atomic<uint64_t> stateWord;
+    // Set once, before the process is handed to other threads
+    std::shared_ptr<StateCounts> stateCounts;
+
+    int lastCore = -1;  // core of the previous slice, kept across sleeps
+    // Written only by the core running the process; monitoring reads it
+    // from other threads, so it is atomic but needs no ordering
+    std::atomic<int> currentInstruction{ 0 };
     int memorySize = 0;
 
     static std::mutex fileMutex;
-    mutable std::mutex stateMutex;
-    
-    bool isFinished = false;
-    bool isSleeping = false;
+
     int remainingSleepCycles = 0;
 
+    std::string rejectionReason;
+
+    uint64_t deadline = 0;  // absolute CPUTick tick, 0 if none
+    int tickets = 100;      // share weight for proportional-share scheduling
+
     int delayCount = 0;
     int maxExecDelay = 0;
 };
\ No newline at end of file
@@ -1,162 +1,247 @@
 #include <algorithm>
-#include <unordered_set>
 #include "ProcessHandler.h"
 
-//void ProcessHandler::insertProcess(const std::shared_ptr<Process>& process) {
-//    std::lock_guard<std::mutex> lock(processMutex);
-//    running.push_back(process);
-//}
+std::atomic<int> ProcessHandler::nextPid{ 1 };
 
-void ProcessHandler::insertProcess(const std::shared_ptr<Process>& process) {
-    std::lock_guard<std::mutex> lock(processMutex);
+ProcessHandler::ProcessHandler(int numCores) {
+    for (int i = 0; i < SHARDS; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+    for (int i = 0; i < numCores; ++i) {
+        cores.push_back(std::make_unique<CoreMembers>());
+    }
+}
 
-    for (const auto& p : running) {
-        if (p->getId() == process->getId()) {
-            return; // Already recorded
-        }
+// Unlinks the finished list one node at a time; left to itself the chain
+// would release recursively, one stack frame per finished process
+ProcessHandler::~ProcessHandler() {
+    auto node = std::move(finishedHead);
+    while (node && node.use_count() == 1) {
+        auto next = node->next;
+        node = std::move(next);
     }
+}
 
-    running.push_back(process);
+int ProcessHandler::allocatePid() {
+    return nextPid++;
 }
 
+ProcessHandler::Shard& ProcessHandler::shardFor(int processId) {
+    return *shards[static_cast<unsigned>(processId) % SHARDS];
+}
 
-bool ProcessHandler::deleteProcess(int processId) {
-    std::lock_guard<std::mutex> lock(processMutex);
-    auto it = std::remove_if(running.begin(), running.end(),
-        [processId](const auto& p) { return p->getId() == processId; });
+void ProcessHandler::joinCore(int coreId, int processId, Handle handle) {
+    if (coreId < 0 || coreId >= static_cast<int>(cores.size())) return;
+    std::lock_guard<std::mutex> lock(cores[coreId]->mutex);
+    cores[coreId]->members[processId] = handle;
+}
 
-    if (it != running.end()) {
-        running.erase(it, running.end());
-        return true;
-    }
-    return false;
+void ProcessHandler::leaveCore(int coreId, int processId) {
+    if (coreId < 0 || coreId >= static_cast<int>(cores.size())) return;
+    std::lock_guard<std::mutex> lock(cores[coreId]->mutex);
+    cores[coreId]->members.erase(processId);
 }
 
-void ProcessHandler::updateProcessState(int processId, bool isFinished) {
-    std::lock_guard<std::mutex> lock(processMutex);
-    for (auto& process : running) {
-        if (process->getId() == processId) {
-            process->setIsFinished(isFinished);
-            break;
+// A core's lock and a shard's lock are never held together: members are
+// copied out and checked against their shards, and stale ones are erased
+// afterwards unless the process has come back to this core in the meantime
+template <typename Visit>
+void ProcessHandler::forEachOnCore(int coreId, Visit visit) {
+    if (coreId < 0 || coreId >= static_cast<int>(cores.size())) return;
+
+    std::vector<std::pair<int, Handle>> members;
+    {
+        std::lock_guard<std::mutex> lock(cores[coreId]->mutex);
+        members.assign(cores[coreId]->members.begin(), cores[coreId]->members.end());
+    }
+
+    std::vector<std::pair<int, std::shared_ptr<Process>>> stale;
+    for (const auto& member : members) {
+        std::shared_ptr<Process> process;
+        {
+            Shard& shard = shardFor(member.first);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            const Slot& slot = shard.slots[member.second.slot];
+            if (slot.generation == member.second.generation) {
+                process = slot.process;
+            }
         }
+        if (!process || process->getAssignedCore() != coreId || process->getIsFinished()) {
+            stale.emplace_back(member.first, process);
+            continue;
+        }
+        if (visit(process)) break;
+    }
+    if (stale.empty()) return;
+
+    std::lock_guard<std::mutex> lock(cores[coreId]->mutex);
+    for (const auto& entry : stale) {
+        const auto& process = entry.second;
+        if (process && process->getAssignedCore() == coreId && !process->getIsFinished()) continue;
+        cores[coreId]->members.erase(entry.first);
     }
 }
 
-std::shared_ptr<Process> ProcessHandler::getProcess(int processId) {
-    std::lock_guard<std::mutex> lock(processMutex);
-    for (const auto& process : running) {
-        if (process->getId() == processId) return process;
+// Inserting again records the process's current core, moving it between
+// per-core member sets
+void ProcessHandler::insertProcess(const std::shared_ptr<Process>& process) {
+    int processId = process->getId();
+    int core = process->getAssignedCore();
+    int previousCore = -1;
+    Handle handle;
+    {
+        Shard& shard = shardFor(processId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(processId);
+        if (it == shard.index.end()) {
+            size_t slotIndex;
+            if (!shard.freeSlots.empty()) {
+                slotIndex = shard.freeSlots.back();
+                shard.freeSlots.pop_back();
+            }
+            else {
+                slotIndex = shard.slots.size();
+                shard.slots.emplace_back();
+            }
+            Slot& slot = shard.slots[slotIndex];
+            slot.process = process;
+            slot.core = core;
+            shard.index.emplace(processId, slotIndex);
+            handle = Handle{ slotIndex, slot.generation };
+        }
+        else {
+            // Already recorded; a lookup may have pruned it from its core
+            // while it was away, so it rejoins even on the same core
+            Slot& slot = shard.slots[it->second];
+            previousCore = slot.core;
+            slot.core = core;
+            handle = Handle{ it->second, slot.generation };
+        }
     }
-    for (const auto& process : finished) {
-        if (process->getId() == processId) return process;
+
+    if (previousCore != core) {
+        leaveCore(previousCore, processId);
     }
-    return nullptr;
+    joinCore(core, processId, handle);
 }
 
-std::vector<std::shared_ptr<Process>> ProcessHandler::getAllProcesses() {
-    std::lock_guard<std::mutex> lock(processMutex);
-    std::vector<std::shared_ptr<Process>> all = running;
-    all.insert(all.end(), finished.begin(), finished.end());
-    return all;
-}
 
-std::vector<std::shared_ptr<Process>> ProcessHandler::getRunningProcesses() {
-    std::lock_guard<std::mutex> lock(processMutex);
+std::shared_ptr<Process> ProcessHandler::releaseSlot(Shard& shard, int processId, int& core) {
+    auto it = shard.index.find(processId);
+    if (it == shard.index.end()) return nullptr;
 
-    std::unordered_set<int> seenIds;
-    std::vector<std::shared_ptr<Process>> uniqueRunning;
+    Slot& slot = shard.slots[it->second];
+    std::shared_ptr<Process> process = std::move(slot.process);
+    core = slot.core;
+    slot.generation++;
+    slot.core = -1;
+    shard.freeSlots.push_back(it->second);
+    shard.index.erase(it);
+    return process;
+}
 
-    for (const auto& p : running) {
-        if (seenIds.insert(p->getId()).second) {
-            uniqueRunning.push_back(p);
-        }
+bool ProcessHandler::deleteProcess(int processId) {
+    int core;
+    {
+        Shard& shard = shardFor(processId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (!releaseSlot(shard, processId, core)) return false;
     }
-
-    return uniqueRunning;
+    leaveCore(core, processId);
+    return true;
 }
 
+void ProcessHandler::updateProcessState(int processId, bool isFinished) {
+    if (auto process = getProcess(processId)) {
+        process->setIsFinished(isFinished);
+    }
+}
 
-std::vector<std::shared_ptr<Process>> ProcessHandler::getFinishedProcesses() {
-    std::lock_guard<std::mutex> lock(processMutex);
+std::shared_ptr<Process> ProcessHandler::getProcess(int processId) {
+    Shard& shard = shardFor(processId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(processId);
+    if (it == shard.index.end()) return nullptr;
+    return shard.slots[it->second].process;
+}
 
-    std::unordered_set<int> seenIds;
-    std::vector<std::shared_ptr<Process>> uniqueFinished;
+// Live processes from the table, then the finished ones
+std::vector<std::shared_ptr<Process>> ProcessHandler::getAllProcesses() {
+    std::vector<std::shared_ptr<Process>> all = getRunningProcesses();
+    auto finishedProcesses = getFinishedProcesses();
+    all.insert(all.end(), finishedProcesses.begin(), finishedProcesses.end());
+    return all;
+}
 
-    for (const auto& p : finished) {
-        if (seenIds.insert(p->getId()).second) {
-            uniqueFinished.push_back(p);
+std::vector<std::shared_ptr<Process>> ProcessHandler::getRunningProcesses() {
+    std::vector<std::shared_ptr<Process>> unfinished;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& slot : shard->slots) {
+            if (slot.process) unfinished.push_back(slot.process);
         }
     }
+    return unfinished;
+}
 
-    return uniqueFinished;
+std::vector<std::shared_ptr<Process>> ProcessHandler::getFinishedProcesses() const {
+    std::vector<std::shared_ptr<Process>> finishedProcesses;
+    for (auto node = std::atomic_load(&finishedHead); node; node = node->next) {
+        finishedProcesses.push_back(node->process);
+    }
+    std::reverse(finishedProcesses.begin(), finishedProcesses.end());
+    return finishedProcesses;
 }
 
 
 std::vector<std::shared_ptr<Process>> ProcessHandler::getProcessesByCore(int coreId) {
-    std::lock_guard<std::mutex> lock(processMutex);
     std::vector<std::shared_ptr<Process>> result;
-    for (const auto& process : running) {
-        if (process->getAssignedCore() == coreId) {
-            result.push_back(process);
-        }
-    }
+    forEachOnCore(coreId, [&result](const std::shared_ptr<Process>& process) {
+        result.push_back(process);
+        return false;
+    });
     return result;
 }
 
 bool ProcessHandler::hasUnfinishedProcessOnCore(int coreId) {
-    std::lock_guard<std::mutex> lock(processMutex);
-    for (const auto& process : running) {
-        if (process->getAssignedCore() == coreId && !process->getIsFinished()) {
-            return true;
-        }
-    }
-    return false;
+    return getFirstUnfinishedProcessOnCore(coreId) != nullptr;
 }
 
 std::shared_ptr<Process> ProcessHandler::getFirstUnfinishedProcessOnCore(int coreId) {
-    std::lock_guard<std::mutex> lock(processMutex);
-    for (const auto& process : running) {
-        if (process->getAssignedCore() == coreId && !process->getIsFinished()) {
-            return process;
-        }
-    }
-    return nullptr;
+    std::shared_ptr<Process> first;
+    forEachOnCore(coreId, [&first](const std::shared_ptr<Process>& process) {
+        first = process;
+        return true;
+    });
+    return first;
 }
 
+// The process moves from the table to the finished list, so the table only
+// ever holds the processes still in play
 void ProcessHandler::markProcessFinished(int processId) {
-    std::lock_guard<std::mutex> lock(processMutex);
-
-    auto it = running.begin();
-    while (it != running.end()) {
-        if ((*it)->getId() == processId) {
-            (*it)->setIsFinished(true);
-            finished.push_back(*it);
-            it = running.erase(it);  // Remove and continue
-        }
-        else {
-            ++it;
-        }
+    std::shared_ptr<Process> process;
+    int core;
+    {
+        Shard& shard = shardFor(processId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        process = releaseSlot(shard, processId, core);
+        if (!process) return;
     }
+    process->setIsFinished(true);
+    leaveCore(core, processId);
+
+    std::lock_guard<std::mutex> lock(finishedMutex);
+    std::atomic_store(&finishedHead, std::make_shared<const FinishedNode>(FinishedNode{ process, finishedHead }));
 }
 
 std::vector<std::shared_ptr<Process>> ProcessHandler::getCurrentlyActiveProcessesPerCore(int numCores) {
-    std::lock_guard<std::mutex> lock(processMutex);
-    std::vector<std::shared_ptr<Process>> active(numCores);
-
-    for (const auto& process : running) {
-        int core = process->getAssignedCore();
-        if (core >= 0 && core < numCores && !process->getIsFinished()) {
-            if (!active[core]) {
-                active[core] = process;
-            }
-        }
-    }
-
-    // Filter out nulls
     std::vector<std::shared_ptr<Process>> result;
-    for (const auto& p : active) {
-        if (p) result.push_back(p);
+    for (int core = 0; core < numCores; ++core) {
+        forEachOnCore(core, [&result](const std::shared_ptr<Process>& process) {
+            if (process->getState() != ProcessState::Running) return false;
+            result.push_back(process);
+            return true;
+        });
     }
     return result;
 }
-
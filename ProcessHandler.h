@@ -4,15 +4,23 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <unordered_map>
 #include "Process.h"
+#include "CacheAligned.h"
 
+// Process table sharded by PID. Each shard indexes PID to a slot, so lookups,
+// inserts and finishes are O(1) and only lock one shard. A finished process
+// leaves the table for the finished list. Its slot is reused, and the slot's
+// generation counter lets a stale handle tell.
 class ProcessHandler {
-private:
-    std::vector<std::shared_ptr<Process>> running;   
-    std::vector<std::shared_ptr<Process>> finished;  
-    mutable std::mutex processMutex;
-
 public:
+    explicit ProcessHandler(int numCores = 0);
+    ~ProcessHandler();
+
+    // One allocator for every process in the program, whoever creates it
+    static int allocatePid();
+
     void insertProcess(const std::shared_ptr<Process>& process);
     bool deleteProcess(int processId);
     void updateProcessState(int processId, bool isFinished);
@@ -20,7 +28,8 @@ public:
 
     std::vector<std::shared_ptr<Process>> getAllProcesses();
     std::vector<std::shared_ptr<Process>> getRunningProcesses();
-    std::vector<std::shared_ptr<Process>> getFinishedProcesses();
+    // Reads the published list without any shard lock
+    std::vector<std::shared_ptr<Process>> getFinishedProcesses() const;
     std::vector<std::shared_ptr<Process>> getProcessesByCore(int coreId);
 
     bool hasUnfinishedProcessOnCore(int coreId);
@@ -30,6 +39,59 @@ public:
 
     std::vector<std::shared_ptr<Process>> getCurrentlyActiveProcessesPerCore(int numCores);
 
+private:
+    static constexpr int SHARDS = 16;
+
+    struct Slot {
+        std::shared_ptr<Process> process;
+        uint32_t generation = 0;
+        int core = -1;  // core recorded at the last insert
+    };
+
+    struct Shard : CacheAligned {
+        std::mutex mutex;
+        std::unordered_map<int, size_t> index;  // PID -> slot
+        std::vector<Slot> slots;
+        std::vector<size_t> freeSlots;
+    };
+
+    struct Handle {
+        size_t slot;
+        uint32_t generation;
+    };
+
+    // Processes last inserted with this core assigned. Entries go stale when
+    // a process leaves the core without being reinserted and are pruned when
+    // a lookup finds them.
+    struct CoreMembers : CacheAligned {
+        std::mutex mutex;
+        std::unordered_map<int, Handle> members;  // PID -> slot handle
+    };
+
+    Shard& shardFor(int processId);
+    // Empties the process's slot for reuse and returns what it held; must
+    // hold the shard's mutex
+    std::shared_ptr<Process> releaseSlot(Shard& shard, int processId, int& core);
+    void joinCore(int coreId, int processId, Handle handle);
+    void leaveCore(int coreId, int processId);
+    // Walks a core's members, pruning stale ones, until visit returns true
+    template <typename Visit>
+    void forEachOnCore(int coreId, Visit visit);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<std::unique_ptr<CoreMembers>> cores;
+
+    // Finished processes as an immutable list, newest first. A finish links
+    // a new head under finishedMutex and swaps it in, so readers load the
+    // head without the lock and never see the list change under them.
+    struct FinishedNode {
+        std::shared_ptr<Process> process;
+        std::shared_ptr<const FinishedNode> next;
+    };
+    std::shared_ptr<const FinishedNode> finishedHead;
+    std::mutex finishedMutex;
+
+    static std::atomic<int> nextPid;
 };
 
 #endif
@@ -0,0 +1,77 @@
+#include "QueueBenchmark.h"
+#include "MPMCQueue.h"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace {
+
+class MutexQueue {
+public:
+    void push(int value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push(value);
+    }
+
+    bool tryPop(int& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.empty()) return false;
+        value = items.front();
+        items.pop();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::queue<int> items;
+};
+
+// Millions of push/pop operations per second across all threads
+template <typename Queue>
+double measure(Queue& queue, int threads, int opsPerThread) {
+    std::atomic<int> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            ready++;
+            while (!go) std::this_thread::yield();
+            int value = 0;
+            for (int i = 0; i < opsPerThread; ++i) {
+                queue.push(i);
+                while (!queue.tryPop(value)) std::this_thread::yield();
+            }
+        });
+    }
+    while (ready < threads) std::this_thread::yield();
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return 2.0 * threads * opsPerThread / elapsed.count() / 1e6;
+}
+
+}
+
+void runQueueBenchmark(int maxThreads, int opsPerThread, std::ostream& out) {
+    out << "Threads   MPMC (Mops/s)   Mutex (Mops/s)\n";
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        // At most one item per thread is in flight, so the ring never fills
+        MPMCQueue<int> ring(threads);
+        MutexQueue locked;
+        double ringRate = measure(ring, threads, opsPerThread);
+        double mutexRate = measure(locked, threads, opsPerThread);
+
+        out << std::setw(7) << threads
+            << std::fixed << std::setprecision(2)
+            << std::setw(16) << ringRate
+            << std::setw(17) << mutexRate << "\n";
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <ostream>
+
+// Compares MPMCQueue with a mutex-guarded std::queue at 1, 2, 4, ... up to
+// maxThreads threads. Every thread pushes an item and pops one, opsPerThread
+// times, so all threads produce and consume at once.
+void runQueueBenchmark(int maxThreads, int opsPerThread, std::ostream& out);
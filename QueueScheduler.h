@@ -0,0 +1,149 @@
+#pragma once
+#include "CoreEngine.h"
+#include <climits>
+
+// Base for schedulers that keep one ready set under queueMutex and only differ
+// in which process runs next and for how long. Cores share the dispatch loop.
+// A policy derives from QueueScheduler<itself> and provides the hooks below
+// as members (befriending QueueScheduler<itself> if they are private), so the
+// hot path calls them directly rather than through the vtable:
+//   void pushReady(std::shared_ptr<Process> process);
+//   std::shared_ptr<Process> popReady();
+//   size_t readyCount() const;
+//   unsigned quantumFor(const std::shared_ptr<Process>& process);
+// It may also replace the defaults of admit, requeue, charge and retire.
+// The hooks are called with queueMutex held.
+template <typename Policy>
+class QueueScheduler : public CoreEngine<Policy> {
+public:
+    QueueScheduler(int numCores, int delays_per_exec, size_t maxMemory, size_t frameSize);
+
+    void addProcess(std::shared_ptr<Process> process) override;
+    void resumeProcess(std::shared_ptr<Process> process) override;
+
+protected:
+    static constexpr unsigned RUN_TO_COMPLETION = UINT_MAX;
+
+    size_t readyDepth() override;
+
+    // New arrivals only; a process that is turned away is never queued. The
+    // policy may explain its decision in notice, which is written out once
+    // queueMutex is released.
+    bool admit(const std::shared_ptr<Process>& process, std::string& notice) { return true; }
+    // A slice ended with the process still runnable
+    void requeue(std::shared_ptr<Process> process, unsigned cyclesUsed) { policy().pushReady(process); }
+    // Every slice, whatever it ended with
+    void charge(const std::shared_ptr<Process>& process, unsigned cyclesUsed) {}
+    void retire(const std::shared_ptr<Process>& process) {}
+
+private:
+    friend class CoreEngine<Policy>;
+    Policy& policy() { return static_cast<Policy&>(*this); }
+    std::shared_ptr<Process> takeNext(int coreId, unsigned& quantum);
+    void finishSlice(int coreId, std::shared_ptr<Process> process, unsigned cyclesUsed);
+};
+
+template <typename Policy>
+QueueScheduler<Policy>::QueueScheduler(int numCores, int delays_per_exec, size_t maxMemory, size_t frameSize)
+    : CoreEngine<Policy>(numCores, maxMemory, frameSize, delays_per_exec) {
+}
+
+// Only memory-resident processes enter the ready set; one that does not fit
+// waits in the memory manager and is resumed once a deallocation admits it.
+template <typename Policy>
+void QueueScheduler<Policy>::addProcess(std::shared_ptr<Process> process) {
+    this->trackProcess(process);
+    if (this->rejectIfTooLarge(process)) {
+        return;
+    }
+
+    std::string notice;
+    bool admitted;
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        admitted = policy().admit(process, notice);
+        if (admitted && this->admitToMemory(process, [this, process]() { resumeProcess(process); })) {
+            policy().pushReady(process);
+            queued = true;
+        }
+    }
+
+    if (!admitted) {
+        process->reject(notice);
+    }
+    else if (!notice.empty()) {
+        process->logInstruction("ADMIT", notice);
+    }
+    if (queued) {
+        this->wakeIdleCore(-1);
+    }
+}
+
+// Woken sleepers and processes granted memory were admitted on arrival and
+// skip admission
+template <typename Policy>
+void QueueScheduler<Policy>::resumeProcess(std::shared_ptr<Process> process) {
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        policy().pushReady(process);
+    }
+    this->wakeIdleCore(-1);
+}
+
+template <typename Policy>
+size_t QueueScheduler<Policy>::readyDepth() {
+    std::lock_guard<std::mutex> lock(this->queueMutex);
+    return policy().readyCount();
+}
+
+// The quantum is worked out in the same critical section as the pop, so it
+// is for the level or position the process was taken from
+template <typename Policy>
+std::shared_ptr<Process> QueueScheduler<Policy>::takeNext(int coreId, unsigned& quantum) {
+    std::shared_ptr<Process> process;
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        process = policy().popReady();
+        if (process) {
+            quantum = policy().quantumFor(process);
+        }
+    }
+    if (process) {
+        process->mustTransition(ProcessState::Ready, ProcessState::Running, coreId);
+        this->processHandler.insertProcess(process);
+    }
+    return process;
+}
+
+template <typename Policy>
+void QueueScheduler<Policy>::finishSlice(int coreId, std::shared_ptr<Process> process, unsigned cyclesUsed) {
+    bool moreReady;
+    if (process->getIsFinished()) {
+        this->processHandler.markProcessFinished(process->getId());
+        this->memoryManager->deallocateMemory(process->getId());
+
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        policy().charge(process, cyclesUsed);
+        policy().retire(process);
+        moreReady = policy().readyCount() > 1;
+    }
+    else if (process->getIsSleeping()) {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        policy().charge(process, cyclesUsed);
+        this->parkSleeping(process);
+        moreReady = policy().readyCount() > 1;
+    }
+    else {
+        process->mustTransition(ProcessState::Running, ProcessState::Ready, -1);
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        policy().charge(process, cyclesUsed);
+        policy().requeue(process, cyclesUsed);
+        moreReady = policy().readyCount() > 1;
+    }
+
+    // This core takes the next one itself; anything beyond that goes to an idle core
+    if (moreReady) {
+        this->wakeIdleCore(-1);
+    }
+}
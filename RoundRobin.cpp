@@ -1,127 +1,257 @@
 #include "RoundRobin.h"
 #include <chrono>
 #include <iostream>
+#include <sstream>
+#include <iomanip>
 
 RRScheduler::RRScheduler(int numCores, int quantum, int delays_per_exec,
     size_t maxMemory, size_t frameSize)
-    : Scheduler(numCores, maxMemory, frameSize),
-    quantum(quantum),
-    delays_per_exec(delays_per_exec) {
+    : CoreEngine(numCores, maxMemory, frameSize, delays_per_exec),
+    quantum(quantum) {
+    // Queued processes are memory resident and hold at least a frame each,
+    // so a ring with a slot per frame never fills; a smaller cap is covered
+    // by spilling to other cores
+    size_t ringSize = std::min<size_t>(4096, std::max<size_t>(16, maxMemory / std::max<size_t>(1, frameSize)));
     for (int i = 0; i < numCores; ++i) {
-        coreAvailable[i] = true;
-        workerThreads.emplace_back(&RRScheduler::workerLoop, this, i);
+        cores[i]->localQueue.resize(ringSize);
+        coreQuanta.push_back(std::make_unique<CoreQuantum>());
+        coreQuanta.back()->quantum = this->quantum;
+    }
+}
+
+void RRScheduler::setAdaptiveQuantum(unsigned minQuantum, unsigned maxQuantum, double targetOverhead) {
+    adaptive = true;
+    this->minQuantum = std::max(1u, minQuantum);
+    this->maxQuantum = std::max(this->minQuantum, maxQuantum);
+    this->targetOverhead = targetOverhead;
+    for (auto& core : coreQuanta) {
+        core->quantum = std::min(this->maxQuantum, std::max(this->minQuantum, quantum));
     }
-    schedulerThread = std::thread(&RRScheduler::schedulerLoop, this);
 }
 
 RRScheduler::~RRScheduler() {
     stop();
 }
 
+// New arrivals go to an idle core if there is one, otherwise they are spread
+// over the cores and stealing evens out the rest. A process that ran before
+// (one waking from SLEEP) goes back to its last core unless that core is more
+// than affinityImbalance behind the spread.
 void RRScheduler::addProcess(std::shared_ptr<Process> process) {
-    std::lock_guard<std::mutex> lock(queueMutex);
-    readyQueue.push(process);
-    cv.notify_one();
+    trackProcess(process);
+    if (rejectIfTooLarge(process)) {
+        return;
+    }
+
+    // A process that does not fit waits outside the rings until a
+    // deallocation makes room, and comes back through here
+    if (!admitToMemory(process, [this, process]() { addProcess(process); })) {
+        return;
+    }
+
+    int lastCore = process->getLastCore();
+    if (lastCore < 0) {
+        // The steal threshold keeps preempted processes near their caches;
+        // fresh work has no cache to keep, so it never waits behind a
+        // running process while a core sits idle
+        int idleCore = claimIdleCore();
+        if (idleCore >= 0) {
+            int target = pushProcess(idleCore, process);
+            signalCore(idleCore);
+            if (target != idleCore) {
+                wakeIdleCore(target);
+            }
+            return;
+        }
+    }
+
+    int coreId = spreadCore();
+    if (lastCore >= 0 && isOnline(lastCore) && lastCore != coreId &&
+        queueLength(lastCore) <= queueLength(coreId) + affinityImbalance) {
+        coreId = lastCore;
+    }
+    wakeIdleCore(pushProcess(coreId, process));
 }
 
-void RRScheduler::schedulerLoop() {
-    while (running) {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        cv.wait(lock, [this]() { return !readyQueue.empty() || !running; });
-        if (!running) break;
+int RRScheduler::spreadCore() {
+    return static_cast<int>(nextEnqueueCore++ % static_cast<unsigned>(std::max(1, getActiveCores())));
+}
 
-        cv.notify_all();  // Wake up all worker threads
-        lock.unlock();
+// Clears the idle flag of the first idle online core, so no other arrival
+// picks it; the caller signals it
+int RRScheduler::claimIdleCore() {
+    for (int i = 0; i < getActiveCores(); ++i) {
+        if (cores[i]->idle.exchange(false)) return i;
+    }
+    return -1;
+}
+
+void RRScheduler::setAffinityImbalance(unsigned affinityImbalance) {
+    this->affinityImbalance = affinityImbalance;
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+// A full ring spills to the next core that has room. If every ring is full
+// the process goes to the overflow list; waiting for room instead could hang
+// a core requeueing its own process. Returns the core to wake.
+int RRScheduler::pushProcess(int coreId, std::shared_ptr<Process> process) {
+    queuedCount++;
+    for (int offset = 0; offset < numCores; ++offset) {
+        int target = (coreId + offset) % numCores;
+        if (offset > 0 && !isOnline(target)) continue;
+        if (cores[target]->localQueue.tryPush(std::move(process))) return target;
     }
+
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    overflow.push_back(std::move(process));
+    overflowCount++;
+    return coreId;
 }
 
+std::shared_ptr<Process> RRScheduler::popOverflow() {
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    if (overflow.empty()) return nullptr;
+    auto process = std::move(overflow.front());
+    overflow.pop_front();
+    overflowCount--;
+    queuedCount--;
+    return process;
+}
 
+// Each core owns the lock-free ready ring in its block, and thieves take from
+// the same end as the owner. Only memory-resident processes are queued, so
+// the head is always runnable.
+std::shared_ptr<Process> RRScheduler::popRunnable(CoreBlock& core) {
+    std::shared_ptr<Process> process;
+    if (!core.localQueue.tryPop(process)) return nullptr;
+    queuedCount--;
+    return process;
+}
 
-void RRScheduler::workerLoop(int coreId) {
-    while (running) {
-        std::shared_ptr<Process> process = nullptr;
+// A busy core's backlog is left to it unless it is more than affinityImbalance
+// deep, so processes stay where their caches are warm. An idle or retired
+// core's ring is always fair game, since nobody else will drain it.
+std::shared_ptr<Process> RRScheduler::takeProcess(int coreId) {
+    // Overflowed processes have waited longest; serve them before the rings
+    if (overflowCount > 0) {
+        if (auto process = popOverflow()) return process;
+    }
 
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            cv.wait(lock, [this]() { return !readyQueue.empty() || !running; });
-            if (!running) break;
+    auto process = popRunnable(*cores[coreId]);
+    if (process) return process;
 
-            // Fair turn-based access per core
-            {
-                std::unique_lock<std::mutex> turnLock(coreTurnMutex);
-                if (coreId != nextCoreId) {
-                    continue;  // Not this core's turn
-                }
-            }
+    for (int offset = 1; offset < numCores; ++offset) {
+        int victim = (coreId + offset) % numCores;
+        if (isOnline(victim) && !cores[victim]->idle && queueLength(victim) <= affinityImbalance) continue;
+        process = popRunnable(*cores[victim]);
+        if (process) return process;
+    }
+    return nullptr;
+}
 
-            // Try to find a process that can run (with memory allocated)
-            size_t attempts = 0;
-            const size_t queueSize = readyQueue.size();
-            
-            while (attempts < queueSize) {
-                auto candidate = readyQueue.front();
-                readyQueue.pop();
-                attempts++;
-
-                if (!memoryManager.isInMemory(candidate->getId())) {
-                    if (!memoryManager.allocateMemory(candidate->getId(), 
-                                                     candidate->getMemoryNeeded())) {
-                        // Can't allocate now, put it back
-                        readyQueue.push(candidate);
-                        continue;
-                    }
-                }
-
-                // Found a runnable process
-                process = candidate;
-                process->setAssignedCore(coreId);
-                coreAvailable[coreId] = false;
-                processHandler.insertProcess(process);
-                break;
-            }
+void RRScheduler::drainCore(int coreId) {
+    while (auto process = popRunnable(*cores[coreId])) {
+        wakeIdleCore(pushProcess(spreadCore(), std::move(process)));
+    }
+}
 
-            // Round-robin core access
-            {
-                std::unique_lock<std::mutex> turnLock(coreTurnMutex);
-                nextCoreId = (nextCoreId + 1) % numCores;
-            }
-        }
+size_t RRScheduler::readyDepth() {
+    return queuedCount;
+}
 
-        if (process) {
-            unsigned cyclesUsed = 0;
-            while (cyclesUsed < quantum && !process->getIsFinished() && running) {
-                process->executeNextInstruction();
-                cyclesUsed++;
-                std::this_thread::sleep_for(std::chrono::milliseconds(delays_per_exec));
-            }
+size_t RRScheduler::queueLength(int coreId) {
+    return cores[coreId]->localQueue.sizeApprox();
+}
 
-            {
-                std::lock_guard<std::mutex> lock(queueMutex);
+std::shared_ptr<Process> RRScheduler::takeNext(int coreId, unsigned& quantum) {
+    auto takeStart = std::chrono::steady_clock::now();
+    std::shared_ptr<Process> process = takeProcess(coreId);
+    if (process) {
+        quantum = coreQuanta[coreId]->quantum;
+        process->mustTransition(ProcessState::Ready, ProcessState::Running, coreId);
+        processHandler.insertProcess(process);
+        coreQuanta[coreId]->takeTime = std::chrono::steady_clock::now() - takeStart;
+    }
+    return process;
+}
 
-                if (process->getIsFinished()) {
-                    processHandler.markProcessFinished(process->getId());
-                    memoryManager.deallocateMemory(process->getId());
-                }
-                else {
-                    // Only requeue if not finished
-                    readyQueue.push(process);
-                }
+// Only slices that used their whole quantum say anything about its size; one
+// that ended in a finish or a sleep would have switched anyway.
+void RRScheduler::adaptQuantum(int coreId, std::chrono::steady_clock::duration switchTime, unsigned cyclesUsed) {
+    auto& core = *coreQuanta[coreId];
+    unsigned current = core.quantum;
+    if (cyclesUsed < current) return;
 
-                coreAvailable[coreId] = true;
-            }
+    double switchNanos = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(switchTime).count());
+    double usefulNanos = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(cores[coreId]->slice.executeTime).count());
+    if (switchNanos + usefulNanos <= 0) return;
 
-            cv.notify_all();
+    double overhead = core.overhead + (switchNanos / (switchNanos + usefulNanos) - core.overhead) / 8;
+    core.overhead = overhead;
 
-            // Generate snapshot from core 0
-            if (coreId == 0 && cyclesUsed > 0) {
-               // std::lock_guard<std::mutex> snapLock(snapshotMutex);
-               // std::string filename = "memory_stamp_" + std::to_string(quantumCycle++) + ".txt";
-                //memoryManager.generateMemorySnapshot(filename, quantumCycle);
+    // Grow quickly while switching costs too much, shrink slowly once it is
+    // well under target so the quantum stays as short as it can afford
+    if (overhead > targetOverhead) {
+        core.quantum = std::min(maxQuantum, current + std::max(1u, current / 4));
+    }
+    else if (overhead < targetOverhead / 2) {
+        core.quantum = std::max(minQuantum, current - std::max(1u, current / 8));
+    }
+}
+
+void RRScheduler::describeQueues(std::vector<std::string>& lines) {
+    if (!adaptive) return;
+
+    int active = getActiveCores();
+    unsigned lowest = maxQuantum, highest = minQuantum;
+    unsigned long long total = 0;
+    double overhead = 0;
+    for (int i = 0; i < active; ++i) {
+        unsigned q = coreQuanta[i]->quantum;
+        lowest = std::min(lowest, q);
+        highest = std::max(highest, q);
+        total += q;
+        overhead += coreQuanta[i]->overhead;
+    }
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1)
+        << "Adaptive quantum: " << lowest << "-" << highest << " (avg " << total / active << ")"
+        << ", switch overhead " << overhead * 100 / active << "% (target " << targetOverhead * 100 << "%)";
+    lines.push_back(line.str());
+}
+
+void RRScheduler::finishSlice(int coreId, std::shared_ptr<Process> process, unsigned cyclesUsed) {
+    auto finishStart = std::chrono::steady_clock::now();
+    if (process->getIsFinished()) {
+        processHandler.markProcessFinished(process->getId());
+        memoryManager->deallocateMemory(process->getId());
+
+        // Processes admitted by the freed memory are handed to idle cores
+        // as they are queued
+    }
+    else if (process->getIsSleeping()) {
+        // Off the core until the sleep expires; the wheel requeues it
+        parkSleeping(process);
+    }
+    else {
+        // Preempted processes stay on this core's ring; if others are
+        // waiting behind it, let an idle core steal them
+        process->mustTransition(ProcessState::Running, ProcessState::Ready, -1);
+        if (!isOnline(coreId)) {
+            wakeIdleCore(pushProcess(spreadCore(), process));
+        }
+        else {
+            int target = pushProcess(coreId, process);
+            if (target != coreId) {
+                wakeIdleCore(target);
+            }
+            else if (queueLength(coreId) > std::max<size_t>(1, affinityImbalance)) {
+                wakeIdleCore(-1);
             }
         }
+    }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (adaptive) {
+        adaptQuantum(coreId, coreQuanta[coreId]->takeTime + (std::chrono::steady_clock::now() - finishStart), cyclesUsed);
     }
 }
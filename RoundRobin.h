@@ -1,28 +1,57 @@
 #pragma once
-#include "Scheduler.h"
-#include <queue>
+#include "CoreEngine.h"
+#include <deque>
 #include <thread>
 
 
-class RRScheduler : public Scheduler {
+class RRScheduler : public CoreEngine<RRScheduler> {
 public:
     RRScheduler(int numCores, int quantum, int delays_per_exec,
         size_t maxMemory, size_t frameSize);
     ~RRScheduler() override;
 
     void addProcess(std::shared_ptr<Process> process);
+    // Lets each core resize its quantum within [minQuantum, maxQuantum] so
+    // that switching stays near targetOverhead (a fraction) of its host time
+    void setAdaptiveQuantum(unsigned minQuantum, unsigned maxQuantum, double targetOverhead);
+    // How many processes a busy core may have waiting before others steal
+    // from it or a woken process is placed elsewhere; 0 always balances
+    void setAffinityImbalance(unsigned affinityImbalance);
 
 private:
-    void schedulerLoop() override;
-    void workerLoop(int coreId) override;
-    int delays_per_exec;
-    unsigned quantum;
-    std::queue<std::shared_ptr<Process>> readyQueue;
-    std::mutex queueMutex;
-    std::atomic<int> nextCoreId = 0;
-    std::mutex coreTurnMutex;
-    std::atomic<int> quantumCycle = 0;
-    std::mutex snapshotMutex;
+    // Per-core switch cost against useful work, as moving averages of host time
+    struct CoreQuantum : CacheAligned {
+        std::atomic<unsigned> quantum{ 0 };
+        std::atomic<double> overhead{ 0.0 };
+        std::chrono::steady_clock::duration takeTime{};
+    };
 
+    void describeQueues(std::vector<std::string>& lines) override;
+    void adaptQuantum(int coreId, std::chrono::steady_clock::duration switchTime, unsigned cyclesUsed);
+    friend class CoreEngine<RRScheduler>;
+    std::shared_ptr<Process> takeNext(int coreId, unsigned& quantum);
+    void finishSlice(int coreId, std::shared_ptr<Process> process, unsigned cyclesUsed);
+    std::shared_ptr<Process> popRunnable(CoreBlock& core);
+    std::shared_ptr<Process> popOverflow();
+    std::shared_ptr<Process> takeProcess(int coreId);
+    int pushProcess(int coreId, std::shared_ptr<Process> process);
+    size_t queueLength(int coreId);
+    int spreadCore();
+    int claimIdleCore();
+    void drainCore(int coreId);
+    size_t readyDepth() override;
 
-};
\ No newline at end of file
+    unsigned quantum;
+    bool adaptive = false;
+    unsigned minQuantum = 1;
+    unsigned maxQuantum = 1;
+    double targetOverhead = 0.05;
+    unsigned affinityImbalance = 1;
+    std::vector<std::unique_ptr<CoreQuantum>> coreQuanta;
+    std::atomic<size_t> queuedCount{ 0 };
+    // Ready processes that found every ring full
+    std::mutex overflowMutex;
+    std::deque<std::shared_ptr<Process>> overflow;
+    std::atomic<size_t> overflowCount{ 0 };
+    std::atomic<unsigned> nextEnqueueCore{ 0 };
+};
@@ -0,0 +1,41 @@
+#include "SJF.h"
+
+SJFScheduler::SJFScheduler(int numCores, bool preemptive, int quantum, int delays_per_exec,
+    size_t maxMemory, size_t frameSize)
+    : QueueScheduler(numCores, delays_per_exec, maxMemory, frameSize),
+    preemptive(preemptive),
+    quantum(static_cast<unsigned>(std::max(1, quantum))) {
+}
+
+SJFScheduler::~SJFScheduler() {
+    stop();
+}
+
+void SJFScheduler::pushReady(std::shared_ptr<Process> process) {
+    size_t remaining = process->getInstructionCount() - process->getCurrentInstructionIndex();
+    readyHeap.push({ remaining, nextSequence++, process });
+}
+
+std::shared_ptr<Process> SJFScheduler::popReady() {
+    if (readyHeap.empty()) return nullptr;
+
+    auto process = readyHeap.top().process;
+    readyHeap.pop();
+    return process;
+}
+
+size_t SJFScheduler::readyCount() const {
+    return readyHeap.size();
+}
+
+unsigned SJFScheduler::quantumFor(const std::shared_ptr<Process>& process) {
+    return preemptive ? quantum : RUN_TO_COMPLETION;
+}
+
+void SJFScheduler::describeQueues(std::vector<std::string>& lines) {
+    std::string line = std::string(preemptive ? "SRTF" : "SJF") + " ready: " + std::to_string(readyHeap.size());
+    if (!readyHeap.empty()) {
+        line += " (shortest remaining: " + std::to_string(readyHeap.top().remaining) + ")";
+    }
+    lines.push_back(line);
+}
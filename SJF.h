@@ -0,0 +1,39 @@
+#pragma once
+#include "QueueScheduler.h"
+#include <queue>
+
+// Shortest-job-first on remaining instructions. Non-preemptive (sjf) runs the
+// chosen process until it finishes or sleeps; preemptive (srtf) re-picks at
+// every quantum boundary. The ready set is a min-heap keyed on remaining work,
+// which only changes while a process is off the heap.
+class SJFScheduler : public QueueScheduler<SJFScheduler> {
+public:
+    SJFScheduler(int numCores, bool preemptive, int quantum, int delays_per_exec,
+        size_t maxMemory, size_t frameSize);
+    ~SJFScheduler() override;
+
+protected:
+    friend class QueueScheduler<SJFScheduler>;
+    void pushReady(std::shared_ptr<Process> process);
+    std::shared_ptr<Process> popReady();
+    size_t readyCount() const;
+    unsigned quantumFor(const std::shared_ptr<Process>& process);
+    void describeQueues(std::vector<std::string>& lines) override;
+
+private:
+    struct Entry {
+        size_t remaining;
+        uint64_t sequence;  // FIFO among equal remaining work
+        std::shared_ptr<Process> process;
+
+        bool operator>(const Entry& other) const {
+            if (remaining != other.remaining) return remaining > other.remaining;
+            return sequence > other.sequence;
+        }
+    };
+
+    bool preemptive;
+    unsigned quantum;
+    uint64_t nextSequence = 0;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> readyHeap;
+};
@@ -2,107 +2,420 @@
 #include <iostream>
 #include <algorithm>
 #include <fstream>
-#include <unordered_set>
 
-Scheduler::Scheduler(int numCores, size_t maxMemory, size_t frameSize)
-    : numCores(numCores), running(false), memoryManager(maxMemory, frameSize) {
-    coreAvailable.resize(numCores, true);
+Scheduler::Scheduler(int numCores, size_t maxMemory, size_t frameSize, int delays_per_exec)
+    : numCores(numCores), delays_per_exec(delays_per_exec), activeCores(numCores), running(false),
+    processHandler(numCores),
+    memoryManager(std::make_shared<MemoryManager>(maxMemory, frameSize)),
+    stateCounts(std::make_shared<StateCounts>()),
+    clock(std::make_shared<CPUTick>()),
+    hostPool(std::make_shared<HostPool>()) {
+    for (int i = 0; i < numCores; ++i) {
+        cores.push_back(std::make_unique<CoreBlock>());
+    }
+    registerTimers();
+}
+
+void Scheduler::registerTimers() {
+    clock->addTimerSource(
+        [this](uint64_t now) { wakeSleepers(now); },
+        [this]() {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            return sleepQueue.nextExpiry();
+        });
+    clock->addTimerSource(
+        [this](uint64_t now) { runShrinkCheck(now); },
+        [this]() { return shrinkCheckTick.load(); });
+}
+
+void Scheduler::shareResources(const Scheduler& owner) {
+    clock = owner.clock;
+    memoryManager = owner.memoryManager;
+    stateCounts = owner.stateCounts;
+    hostPool = owner.hostPool;
+    registerTimers();
+}
+
+void Scheduler::setCoreBase(int coreBase) {
+    this->coreBase = coreBase;
+}
+
+void Scheduler::setHostThreads(int hostThreads) {
+    this->hostThreads = hostThreads;
+}
+
+void Scheduler::setCpuAffinity(const CpuAffinity& cpuAffinity) {
+    this->cpuAffinity = cpuAffinity;
+}
+
+const std::vector<std::string>& Scheduler::describeAffinity() const {
+    return affinityReport;
+}
+
+// Added cores come up through the usual wakeup. Removed ones are signalled
+// too, so that an idle one also gets to hand back its queue.
+bool Scheduler::setActiveCores(int cores) {
+    cores = std::max(1, std::min(cores, numCores));
+    int previous = activeCores.exchange(cores);
+    if (running) {
+        for (int i = std::min(previous, cores); i < std::max(previous, cores); ++i) {
+            signalCore(i);
+        }
+    }
+    return true;
+}
+
+int Scheduler::getActiveCores() const {
+    return activeCores;
+}
+
+void Scheduler::setAutoscale(int minCores, unsigned depthPerCore, uint64_t cooldownTicks) {
+    autoscaling = true;
+    autoscaleMin = std::max(1, minCores);
+    autoscaleDepth = std::max(1u, depthPerCore);
+    autoscaleCooldown = cooldownTicks;
+}
+
+// Called by a core after a slice, or with idle set when it found nothing to
+// run. Only the highest active core is retired, and only while it is idle, so
+// the active cores stay a prefix of the allocated ones.
+void Scheduler::autoscale(bool idle) {
+    uint64_t now = clock->getTick();
+    uint64_t last = lastScaleTick;
+    if (last != 0 && now < last + autoscaleCooldown) {
+        // A parked core will not look again, so the clock retries the shrink
+        if (idle) {
+            scheduleShrinkCheck(last + autoscaleCooldown);
+        }
+        return;
+    }
+
+    int active = activeCores;
+    int target;
+    if (idle) {
+        if (active <= autoscaleMin || !cores[active - 1]->idle || readyDepth() > 0) return;
+        target = active - 1;
+    }
+    else {
+        if (active >= numCores || readyDepth() <= static_cast<size_t>(active) * autoscaleDepth) return;
+        target = active + 1;
+    }
+
+    if (lastScaleTick.compare_exchange_strong(last, std::max<uint64_t>(now, 1))) {
+        setActiveCores(target);
+        // The next core down may be idle too
+        if (idle) {
+            scheduleShrinkCheck(now + autoscaleCooldown);
+        }
+    }
+}
+
+void Scheduler::scheduleShrinkCheck(uint64_t tick) {
+    uint64_t due = shrinkCheckTick;
+    while (tick < due && !shrinkCheckTick.compare_exchange_weak(due, tick)) {
+    }
+}
+
+// Timer side of autoscale, for when every core above min-cpu has parked
+void Scheduler::runShrinkCheck(uint64_t now) {
+    uint64_t due = shrinkCheckTick;
+    if (now < due || !shrinkCheckTick.compare_exchange_strong(due, UINT64_MAX)) return;
+    autoscale(true);
 }
 
 Scheduler::~Scheduler() {
     stop();
 }
 
+// Emulated cores are multiplexed onto a fixed pool of host threads, so a wide
+// configuration does not cost one OS thread per core
 void Scheduler::start() {
     if (!running) {
         running = true;
+        startHostPool();
+        for (int i = 0; i < numCores; ++i) {
+            if (!isOnline(i)) {
+                cores[i]->parked = true;
+                continue;
+            }
+            // Cores start out busy; they leave the clock when they go idle
+            clock->attach();
+            submitCore(i);
+        }
+    }
+}
+
+// Never more host threads than emulated cores; a pool that is already running
+// (shared with another scheduler) is left as it is
+void Scheduler::startHostPool() {
+    int threads = hostThreads > 0 ? hostThreads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, numCores));
+    if (hostPool->start(threads)) {
+        applyAffinity(threads);
+    }
+}
+
+// The clock thread takes the slot after the host threads
+void Scheduler::applyAffinity(int threads) {
+    affinityReport.clear();
+    if (!cpuAffinity.isEnabled()) return;
+
+    auto pinned = [](bool ok, int cpu) {
+        return ok ? "CPU " + std::to_string(cpu) : "CPU " + std::to_string(cpu) + " (not pinned)";
+    };
+    for (int i = 0; i < threads; ++i) {
+        int cpu = cpuAffinity.cpuFor(i, threads + 1);
+        affinityReport.push_back("  host thread " + std::to_string(i) + " -> " + pinned(hostPool->pinThread(i, cpu), cpu));
+    }
+    if (!clock->isVirtual()) {
+        int cpu = cpuAffinity.cpuFor(threads, threads + 1);
+        affinityReport.push_back("  clock thread -> " + pinned(clock->pinThread(cpu), cpu));
     }
 }
 
 void Scheduler::stop() {
     if (running) {
         running = false;
-        cv.notify_all();  
+        clock->stop();
+        hostPool->stop();
+    }
+}
+
+CPUTick& Scheduler::getClock() {
+    return *clock;
+}
 
-        if (schedulerThread.joinable()) {
-            schedulerThread.join();
+// The signaller attaches a parked core to the clock on its behalf, so virtual
+// time cannot run ahead before the core gets to its work. A core that is not
+// parked just notes the signal and looks again before it parks.
+void Scheduler::signalCore(int coreId) {
+    auto& signal = *cores[coreId];
+    bool wasParked;
+    {
+        std::lock_guard<std::mutex> lock(signal.mutex);
+        wasParked = signal.parked;
+        if (wasParked) {
+            signal.parked = false;
+            clock->attach();
         }
+        else {
+            signal.pending = true;
+        }
+    }
+    if (wasParked) {
+        submitCore(coreId);
+    }
+}
 
-        for (auto& thread : workerThreads) {
-            if (thread.joinable()) {
-                thread.join();
-            }
+// Gives up the host thread until the core is signalled. The clock is left
+// outside the signal mutex, since that can fire timers that signal this core.
+void Scheduler::parkCore(int coreId) {
+    auto& signal = *cores[coreId];
+    {
+        std::lock_guard<std::mutex> lock(signal.mutex);
+        if (signal.pending) {
+            signal.pending = false;
+            submitCore(coreId);
+            return;
         }
+        signal.parked = true;
     }
+    clock->detach();
 }
 
-void Scheduler::listProcesses() {
-    std::lock_guard<std::mutex> lock(queueMutex);
-    lastPrintedProcessLines.clear();
+void Scheduler::submitCore(int coreId) {
+    hostPool->submit([this, coreId]() { runCore(coreId); });
+}
 
-     auto runningProcs = processHandler.getCurrentlyActiveProcessesPerCore(numCores);
-    //auto runningProcs = processHandler.getRunningProcesses();
-    auto finishedProcs = processHandler.getFinishedProcesses();
+// Wakes the preferred core if it is idle, otherwise any idle core.
+bool Scheduler::wakeIdleCore(int preferredCore) {
+    if (preferredCore >= 0 && isOnline(preferredCore) && cores[preferredCore]->idle.exchange(false)) {
+        signalCore(preferredCore);
+        return true;
+    }
+    for (int i = 0; i < activeCores; ++i) {
+        if (cores[i]->idle.exchange(false)) {
+            signalCore(i);
+            return true;
+        }
+    }
+    return false;
+}
 
-    /*int coresUsed = 0;
-   for (bool available : coreAvailable) {
-       if (!available) coresUsed++;
-   }*/
-    std::unordered_set<int> usedCores;
-    for (const auto& p : runningProcs) {
-        usedCores.insert(p->getAssignedCore());
+// SLEEP n lasts n instruction cycles of 1 + delays_per_exec ticks each, as
+// virtual time charges them, so it means the same in both clock modes
+void Scheduler::parkSleeping(std::shared_ptr<Process> process) {
+    process->setAssignedCore(-1);
+    uint64_t ticks = static_cast<uint64_t>(process->getRemainingSleepCycles()) * (1 + delays_per_exec);
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    sleepQueue.schedule(clock->getTick() + ticks, process);
+}
+
+// The process is marked WAITING_MEMORY before it can be registered as a
+// waiter, so an admission on another thread always finds it in that state.
+// A process already resident (one waking from SLEEP) passes straight through.
+bool Scheduler::admitToMemory(std::shared_ptr<Process> process, std::function<void()> onAdmitted) {
+    process->transition(ProcessState::New, ProcessState::WaitingMemory);
+    if (!memoryManager->allocateOrWait(process->getId(), process->getMemoryNeeded(),
+        [process, onAdmitted]() {
+            process->mustTransition(ProcessState::WaitingMemory, ProcessState::Ready);
+            onAdmitted();
+        })) {
+        return false;
     }
-    int coresUsed = static_cast<int>(usedCores.size());
+    process->transition(ProcessState::WaitingMemory, ProcessState::Ready);
+    return true;
+}
 
-    int coresAvailable = numCores - coresUsed;
-    int cpuUtilization = static_cast<int>((static_cast<float>(coresUsed) / numCores) * 100);
+void Scheduler::trackProcess(const std::shared_ptr<Process>& process) {
+    process->attachStateCounts(stateCounts);
+}
 
-    std::cout << "\n=== Process List ===\n";
-    lastPrintedProcessLines.push_back("=== Process List ===");
+bool Scheduler::rejectIfTooLarge(const std::shared_ptr<Process>& process) {
+    if (memoryManager->canEverFit(process->getMemoryNeeded())) return false;
+    return process->reject("needs " + std::to_string(process->getMemoryNeeded())
+        + " bytes of memory, more than max-overall-mem (" + std::to_string(memoryManager->getMaxMemory()) + ")");
+}
 
-    std::string cpuUtil = "CPU utilization: " + std::to_string(cpuUtilization) + "%";
-    std::string usedLine = "Cores used: " + std::to_string(coresUsed);
-    std::string availLine = "Cores available: " + std::to_string(coresAvailable);
+void Scheduler::wakeSleepers(uint64_t now) {
+    std::vector<std::shared_ptr<Process>> woken;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        sleepQueue.advance(now, woken);
+    }
+    for (auto& process : woken) {
+        process->setSleeping(false, 0);
+        resumeProcess(process);
+    }
+}
 
-    std::cout << cpuUtil << "\n" << usedLine << "\n" << availLine << "\n";
-    lastPrintedProcessLines.push_back(cpuUtil);
-    lastPrintedProcessLines.push_back(usedLine);
-    lastPrintedProcessLines.push_back(availLine);
+void Scheduler::resumeProcess(std::shared_ptr<Process> process) {
+    addProcess(process);
+}
 
-    std::string runningHeader = "\nRunning processes (" + std::to_string(runningProcs.size()) + "):";
-    std::cout << runningHeader << "\n";
-    lastPrintedProcessLines.push_back(runningHeader);
+void Scheduler::listProcesses() {
+    std::vector<std::string> lines;
+    lines.push_back("=== Process List ===");
+    appendProcessStatus(lines);
 
-    std::unordered_set<int> printedProcessIds;
+    std::string states = "\nProcess states:";
+    for (int i = 0; i < static_cast<int>(ProcessState::Count); ++i) {
+        auto state = static_cast<ProcessState>(i);
+        states += std::string(i ? ", " : " ") + Process::stateName(state) + " " + std::to_string((*stateCounts)[i].load());
+    }
+    lines.push_back(states);
 
-    for (const auto& process : runningProcs) {
-        int pid = process->getId();
-        if (printedProcessIds.count(pid)) continue;  // skip duplicate
+    std::cout << "\n";
+    for (const auto& line : lines) {
+        std::cout << line << "\n";
+    }
 
-        printedProcessIds.insert(pid);
+    lines.push_back("===================\n");
+    std::atomic_store(&lastPrintedProcessLines, std::make_shared<const std::vector<std::string>>(std::move(lines)));
+}
 
-        std::string processLog = "  " + process->getName() +
-            " (ID: " + std::to_string(pid) + ")  (" + process->getCreationTime() +
-            ")  on Core: " + std::to_string(process->getAssignedCore()) +
-            "  " + std::to_string(process->getCurrentInstructionIndex()) + "/" +
-            std::to_string(process->getInstructionCount());
+int Scheduler::countBusyCores() {
+    int busy = 0;
+    for (const auto& core : cores) {
+        if (core->current) ++busy;
+    }
+    return busy;
+}
 
-        std::cout << processLog << "\n";
-        lastPrintedProcessLines.push_back(processLog);
+// Only the queue description takes queueMutex, and it is a few lines of
+// counts; the per-process lines are built from the core blocks and the
+// published finished list without holding anything dispatch needs
+void Scheduler::appendProcessStatus(std::vector<std::string>& lines) {
+    // Read off the core blocks rather than scanning the process list
+    std::vector<std::pair<int, Process*>> runningProcs;
+    for (int i = 0; i < numCores; ++i) {
+        if (Process* process = cores[i]->current) {
+            runningProcs.emplace_back(i, process);
+        }
+    }
+    auto finishedProcs = processHandler.getFinishedProcesses();
+
+    int active = activeCores;
+    int coresUsed = countBusyCores();
+    int coresAvailable = std::max(0, active - coresUsed);
+    int cpuUtilization = static_cast<int>((static_cast<float>(std::min(coresUsed, active)) / active) * 100);
+
+    lines.push_back("CPU utilization: " + std::to_string(cpuUtilization) + "%");
+    lines.push_back("Cores used: " + std::to_string(coresUsed));
+    lines.push_back("Cores available: " + std::to_string(coresAvailable));
+    if (active != numCores || autoscaling) {
+        lines.push_back("Cores active: " + std::to_string(active) + " of " + std::to_string(numCores));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        describeQueues(lines);
     }
 
+    lines.push_back("\nRunning processes (" + std::to_string(runningProcs.size()) + "):");
 
-    std::string finishedHeader = "\nFinished processes (" + std::to_string(finishedProcs.size()) + "):";
-    std::cout << finishedHeader << "\n";
-    lastPrintedProcessLines.push_back(finishedHeader);
+    for (const auto& running : runningProcs) {
+        Process* process = running.second;
+        lines.push_back("  " + process->getName() +
+            " (ID: " + std::to_string(process->getId()) + ")  (" + process->getCreationTime() +
+            ")  on Core: " + std::to_string(coreBase + running.first) +
+            "  " + std::to_string(process->getCurrentInstructionIndex()) + "/" +
+            std::to_string(process->getInstructionCount()));
+    }
+
+    lines.push_back("\nFinished processes (" + std::to_string(finishedProcs.size()) + "):");
 
     for (const auto& process : finishedProcs) {
-        std::string line = "  " + process->getName() +
-            " (ID: " + std::to_string(process->getId()) + ")   Finished!";
-        std::cout << line << "\n";
-        lastPrintedProcessLines.push_back(line);
+        lines.push_back("  " + process->getName() +
+            " (ID: " + std::to_string(process->getId()) + ")   Finished!");
     }
-    lastPrintedProcessLines.push_back("===================\n");
+}
+
+std::vector<std::string> Scheduler::buildReportExtras() {
+    std::vector<std::string> lines;
+    describeCoreStats(lines);
+    describeReport(lines);
+    return lines;
+}
+
+// Only called from the core's own step, so lastProcessId needs no lock
+void Scheduler::recordDispatch(int coreId, Process& process) {
+    auto& stats = cores[coreId]->stats;
+    stats.dispatches++;
+    if (process.getId() != stats.lastProcessId) {
+        stats.contextSwitches++;
+        stats.lastProcessId = process.getId();
+    }
+
+    int lastCore = process.getLastCore();
+    if (lastCore == coreId) {
+        stats.sameCore++;
+    }
+    else if (lastCore >= 0) {
+        stats.migrations++;
+    }
+    process.setLastCore(coreId);
+}
+
+void Scheduler::describeCoreStats(std::vector<std::string>& lines) {
+    uint64_t dispatches = 0, contextSwitches = 0, sameCore = 0, migrations = 0;
+    for (auto& core : cores) {
+        dispatches += core->stats.dispatches;
+        contextSwitches += core->stats.contextSwitches;
+        sameCore += core->stats.sameCore;
+        migrations += core->stats.migrations;
+    }
+    if (dispatches == 0) return;
+
+    lines.push_back("Dispatches per core (slices, context switches, same-core, migrations):");
+    for (int i = 0; i < numCores; ++i) {
+        auto& stats = cores[i]->stats;
+        lines.push_back("  Core " + std::to_string(coreBase + i) + ": " +
+            std::to_string(stats.dispatches) + ", " + std::to_string(stats.contextSwitches) + ", " +
+            std::to_string(stats.sameCore) + ", " + std::to_string(stats.migrations));
+    }
+    lines.push_back("  Total: " + std::to_string(dispatches) + ", " + std::to_string(contextSwitches) + ", " +
+        std::to_string(sameCore) + ", " + std::to_string(migrations));
 }
 
 bool MemoryManager::isInMemory(int pid) const {
@@ -115,7 +428,8 @@ bool MemoryManager::isInMemory(int pid) const {
 
 
 void Scheduler::generateReport(const std::string& filename) {
-    std::lock_guard<std::mutex> lock(queueMutex);
+    auto reportLines = buildReportExtras();
+    auto processLines = std::atomic_load(&lastPrintedProcessLines);
 
     std::ofstream outputFile(filename);
     /*if (!outputFile.is_open()) {
@@ -123,7 +437,13 @@ void Scheduler::generateReport(const std::string& filename) {
         return;
     }*/
 
-    for (const auto& line : lastPrintedProcessLines) {
+    if (processLines) {
+        for (const auto& line : *processLines) {
+            outputFile << line << "\n";
+        }
+    }
+
+    for (const auto& line : reportLines) {
         outputFile << line << "\n";
     }
 
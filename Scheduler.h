@@ -2,6 +2,12 @@
 #include "MemoryManager.h"
 #include "Process.h"
 #include "ProcessHandler.h"
+#include "CPUTick.h"
+#include "TimerWheel.h"
+#include "HostPool.h"
+#include "CpuAffinity.h"
+#include "CacheAligned.h"
+#include "MPMCQueue.h"
 #include <vector>
 #include <memory>
 #include <thread>
@@ -10,10 +16,12 @@
 #include <atomic>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
 
 class Scheduler {
 public:
-    Scheduler(int numCores, size_t maxMemory, size_t frameSize);
+    Scheduler(int numCores, size_t maxMemory, size_t frameSize, int delays_per_exec);
     virtual ~Scheduler();
 
     virtual void start();
@@ -22,25 +30,141 @@ public:
     virtual void listProcesses();
     virtual void generateReport(const std::string& filename);
 
+    CPUTick& getClock();
+    // Run on another scheduler's clock, memory and host threads; call before start()
+    void shareResources(const Scheduler& owner);
+    void setCoreBase(int coreBase);
+    // 0 sizes the host pool to the hardware
+    void setHostThreads(int hostThreads);
+    // Applied when the host pool starts; call after the clock has started
+    void setCpuAffinity(const CpuAffinity& cpuAffinity);
+
+    // Cores beyond the active count hand their work to the others and park.
+    // The count can change while running, up to the cores the scheduler was
+    // built with. Returns false when the scheduler cannot be resized.
+    virtual bool setActiveCores(int cores);
+    int getActiveCores() const;
+    // Grows by a core when more than depthPerCore processes per active core
+    // are waiting, and retires the highest core while it is idle, at most
+    // once every cooldownTicks; a shrink held back by the cooldown is retried
+    // from the clock
+    void setAutoscale(int minCores, unsigned depthPerCore, uint64_t cooldownTicks);
+    const std::vector<std::string>& describeAffinity() const;
+
+    int countBusyCores();
+    virtual void appendProcessStatus(std::vector<std::string>& lines);
+    std::vector<std::string> buildReportExtras();
+
 protected:
-    int numCores;
-    std::vector<std::thread> workerThreads;
-    std::thread schedulerThread;
+    int numCores;  // cores allocated; at most this many can be active
+    int delays_per_exec;
+    std::atomic<int> activeCores;
     std::mutex queueMutex;
-    std::condition_variable cv;
     std::atomic<bool> running;
-    std::vector<std::shared_ptr<Process>> runningProcesses;
-    std::vector<std::shared_ptr<Process>> finishedProcesses;
-    std::vector<bool> coreAvailable;
     ProcessHandler processHandler;
-    std::vector<std::string> lastPrintedProcessLines;
-    MemoryManager memoryManager;
+    // Swapped in whole by listProcesses, read by generateReport
+    std::shared_ptr<const std::vector<std::string>> lastPrintedProcessLines;
+    std::shared_ptr<MemoryManager> memoryManager;
+    std::shared_ptr<StateCounts> stateCounts;
+    std::shared_ptr<CPUTick> clock;
+    std::shared_ptr<HostPool> hostPool;
+    int hostThreads = 0;
+    CpuAffinity cpuAffinity;
+    std::vector<std::string> affinityReport;
+    int coreBase = 0;  // first core number shown for this scheduler's cores
+
+    // The slice an emulated core is in the middle of, kept between host steps
+    struct CoreSlice {
+        std::shared_ptr<Process> process;
+        unsigned quantum = 0;
+        unsigned cyclesUsed = 0;
+        bool executed = false;
+        std::chrono::steady_clock::duration executeTime{};  // host time spent on instructions
+    };
+
+    // Dispatch accounting for report-util. A context switch is a dispatch of a
+    // different process than the core ran last; same-core and migration count
+    // where the process's previous slice ran.
+    struct CoreStats {
+        std::atomic<uint64_t> dispatches{ 0 };
+        std::atomic<uint64_t> contextSwitches{ 0 };
+        std::atomic<uint64_t> sameCore{ 0 };
+        std::atomic<uint64_t> migrations{ 0 };
+        int lastProcessId = -1;
+    };
+
+    // Everything a core's own steps touch, one cache-line-aligned block per
+    // core so host threads stepping different cores never share a line.
+    // Signals wake only the core that has to act on an event; a parked core
+    // holds no host thread, and signalling it puts it back in the pool.
+    struct CoreBlock : CacheAligned {
+        std::mutex mutex;
+        bool pending = false;
+        bool parked = false;
+        std::atomic<bool> idle{ false };
+        std::atomic<bool> available{ true };  // no process dispatched to it (FCFS)
+        // What the core is running, for monitoring. The process handler keeps
+        // every dispatched process alive, so the raw pointer stays valid.
+        std::atomic<Process*> current{ nullptr };
+        CoreSlice slice;
+        CoreStats stats;
+        // Ready processes queued on this core, for policies that keep one per
+        // core; sized by the policy before start
+        MPMCQueue<std::shared_ptr<Process>> localQueue;
+    };
+    std::vector<std::unique_ptr<CoreBlock>> cores;
+
+    void signalCore(int coreId);
+    bool wakeIdleCore(int preferredCore);
+    void recordDispatch(int coreId, Process& process);
+    void describeCoreStats(std::vector<std::string>& lines);
+
+    bool isOnline(int coreId) const { return coreId < activeCores; }
+    // Ready processes not on a core, for the autoscaler
+    virtual size_t readyDepth() { return 0; }
+    // Hands a retired core's queued processes to the active cores
+    void drainCore(int coreId) {}
+    void autoscale(bool idle);
+    bool autoscaling = false;
+    int autoscaleMin = 1;
+    unsigned autoscaleDepth = 2;
+    uint64_t autoscaleCooldown = 0;
+    std::atomic<uint64_t> lastScaleTick{ 0 };
+    std::atomic<uint64_t> shrinkCheckTick{ UINT64_MAX };
+    void scheduleShrinkCheck(uint64_t tick);
+    void runShrinkCheck(uint64_t now);
+
+    void startHostPool();
+    void applyAffinity(int threads);
+    void submitCore(int coreId);
+    void parkCore(int coreId);
+    // One host step of an emulated core; see CoreEngine
+    virtual void runCore(int coreId) = 0;
+
+    // Sleeping processes are parked off-core until their timer fires
+    TimerWheel sleepQueue;
+    std::mutex sleepMutex;
+    void registerTimers();
+    void parkSleeping(std::shared_ptr<Process> process);
+    bool admitToMemory(std::shared_ptr<Process> process, std::function<void()> onAdmitted);
+    // Turns away a new process that needs more than max-overall-mem; called
+    // before any scheduler lock, since rejecting writes the process log
+    bool rejectIfTooLarge(const std::shared_ptr<Process>& process);
+    // Counts the process in this scheduler's per-state totals; every
+    // addProcess starts with it
+    void trackProcess(const std::shared_ptr<Process>& process);
+    void wakeSleepers(uint64_t now);
+    virtual void resumeProcess(std::shared_ptr<Process> process);
+
+    // Extra ready-queue lines for screen -ls; called with queueMutex held
+    virtual void describeQueues(std::vector<std::string>& lines) {}
+    // Extra lines appended by report-util; called without queueMutex, which
+    // an override takes only long enough to copy what it reports
+    virtual void describeReport(std::vector<std::string>& lines) {}
 
-    virtual void schedulerLoop() = 0;
-    virtual void workerLoop(int coreId) = 0;
     int findAvailableCore() {
-        for (int i = 0; i < numCores; ++i) {
-            if (coreAvailable[i]) {
+        for (int i = 0; i < activeCores; ++i) {
+            if (cores[i]->available) {
                 return i;
             }
         }
@@ -0,0 +1,97 @@
+#include "Stride.h"
+#include <iomanip>
+#include <sstream>
+
+StrideScheduler::StrideScheduler(int numCores, int quantum, int delays_per_exec,
+    size_t maxMemory, size_t frameSize)
+    : QueueScheduler(numCores, delays_per_exec, maxMemory, frameSize),
+    quantum(static_cast<unsigned>(std::max(1, quantum))) {
+}
+
+StrideScheduler::~StrideScheduler() {
+    stop();
+}
+
+StrideScheduler::ShareState& StrideScheduler::stateFor(const std::shared_ptr<Process>& process) {
+    auto it = shares.find(process->getId());
+    if (it == shares.end()) {
+        ShareState state;
+        state.process = process;
+        state.pass = lastPass;
+        it = shares.emplace(process->getId(), state).first;
+    }
+    return it->second;
+}
+
+// A process coming back from sleep may not bank the time it was away
+void StrideScheduler::pushReady(std::shared_ptr<Process> process) {
+    auto& state = stateFor(process);
+    state.pass = std::max(state.pass, lastPass);
+    readyHeap.push({ state.pass, nextSequence++, process });
+}
+
+std::shared_ptr<Process> StrideScheduler::popReady() {
+    if (readyHeap.empty()) return nullptr;
+
+    auto entry = readyHeap.top();
+    readyHeap.pop();
+    lastPass = entry.pass;
+    return entry.process;
+}
+
+size_t StrideScheduler::readyCount() const {
+    return readyHeap.size();
+}
+
+unsigned StrideScheduler::quantumFor(const std::shared_ptr<Process>& process) {
+    return quantum;
+}
+
+void StrideScheduler::charge(const std::shared_ptr<Process>& process, unsigned cyclesUsed) {
+    auto& state = stateFor(process);
+    state.pass += (STRIDE_SCALE / process->getTickets()) * cyclesUsed;
+    state.cyclesRun += cyclesUsed;
+}
+
+void StrideScheduler::retire(const std::shared_ptr<Process>& process) {
+    shares.erase(process->getId());
+}
+
+// Only the copy of each share is made under queueMutex; the per-process
+// lines are formatted after it is released, so stride cores keep dispatching
+void StrideScheduler::describeReport(std::vector<std::string>& lines) {
+    struct Share {
+        std::shared_ptr<Process> process;
+        int tickets;
+        uint64_t cyclesRun;
+    };
+    std::vector<Share> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        snapshot.reserve(shares.size());
+        for (const auto& entry : shares) {
+            snapshot.push_back({ entry.second.process, entry.second.process->getTickets(), entry.second.cyclesRun });
+        }
+    }
+
+    uint64_t totalTickets = 0;
+    uint64_t totalCycles = 0;
+    for (const auto& share : snapshot) {
+        totalTickets += share.tickets;
+        totalCycles += share.cyclesRun;
+    }
+
+    lines.push_back("Stride shares (" + std::to_string(snapshot.size()) + " unfinished processes):");
+    for (const auto& share : snapshot) {
+        double entitled = totalTickets ? 100.0 * share.tickets / totalTickets : 0.0;
+        double observed = totalCycles ? 100.0 * share.cyclesRun / totalCycles : 0.0;
+
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1)
+            << "  " << share.process->getName() << " (ID: " << share.process->getId() << ")"
+            << "  tickets: " << share.tickets
+            << "  observed: " << observed << "%"
+            << "  entitled: " << entitled << "%";
+        lines.push_back(line.str());
+    }
+}
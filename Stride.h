@@ -0,0 +1,53 @@
+#pragma once
+#include "QueueScheduler.h"
+#include <queue>
+#include <unordered_map>
+
+// Proportional-share stride scheduling. Each process advances its pass by
+// STRIDE_SCALE / tickets for every cycle it runs, and the lowest pass runs
+// next, so over time CPU time is split in proportion to tickets.
+class StrideScheduler : public QueueScheduler<StrideScheduler> {
+public:
+    StrideScheduler(int numCores, int quantum, int delays_per_exec,
+        size_t maxMemory, size_t frameSize);
+    ~StrideScheduler() override;
+
+protected:
+    friend class QueueScheduler<StrideScheduler>;
+    void pushReady(std::shared_ptr<Process> process);
+    std::shared_ptr<Process> popReady();
+    size_t readyCount() const;
+    unsigned quantumFor(const std::shared_ptr<Process>& process);
+    void charge(const std::shared_ptr<Process>& process, unsigned cyclesUsed);
+    void retire(const std::shared_ptr<Process>& process);
+    void describeReport(std::vector<std::string>& lines) override;
+
+private:
+    static constexpr uint64_t STRIDE_SCALE = 1 << 20;
+
+    struct Entry {
+        uint64_t pass;
+        uint64_t sequence;
+        std::shared_ptr<Process> process;
+
+        bool operator>(const Entry& other) const {
+            if (pass != other.pass) return pass > other.pass;
+            return sequence > other.sequence;
+        }
+    };
+
+    struct ShareState {
+        std::shared_ptr<Process> process;
+        uint64_t pass = 0;
+        uint64_t cyclesRun = 0;
+    };
+
+    ShareState& stateFor(const std::shared_ptr<Process>& process);
+
+    unsigned quantum;
+    uint64_t nextSequence = 0;
+    uint64_t lastPass = 0;  // pass of the last dispatch; late joiners start here
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> readyHeap;
+    // Processes that have not finished, whether ready, running or asleep
+    std::unordered_map<int, ShareState> shares;
+};
@@ -1,66 +1,356 @@
 #include "SymbolTable.h"
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
 
-bool SymbolTable::checkVarExists(const std::string& varName)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SYMBOL_TABLE_SSE2
+#endif
+
+SymbolTable::SymbolTable()
+{
+    clear();
+}
+
+// FNV-1a; the low 7 bits become the control tag, the rest pick the group
+uint32_t SymbolTable::hashOf(const std::string& varName)
 {
-    // if its not present, return 0
-    if (symbolTable.find(varName) == symbolTable.end()) {
-        return false;
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : varName) {
+        hash = (hash ^ c) * 16777619u;
     }
-    return true;
+    return hash;
+}
+
+int8_t* SymbolTable::controls()
+{
+    return heapControl.empty() ? inlineControl : heapControl.data();
+}
+
+const int8_t* SymbolTable::controls() const
+{
+    return heapControl.empty() ? inlineControl : heapControl.data();
+}
+
+SymbolTable::Entry* SymbolTable::slots()
+{
+    return heapEntries.empty() ? inlineEntries : heapEntries.data();
+}
+
+const SymbolTable::Entry* SymbolTable::slots() const
+{
+    return heapEntries.empty() ? inlineEntries : heapEntries.data();
 }
 
-std::string SymbolTable::retrieveValue(const std::string& varName)
+// Unaligned load: the table may be on a heap block with no 16-byte guarantee
+uint32_t SymbolTable::matchGroup(size_t group, int8_t tag) const
 {
-    if (checkVarExists(varName)) {
-        return symbolTable.at(varName).value;
+    const int8_t* bytes = controls() + group * GROUP_SIZE;
+#ifdef SYMBOL_TABLE_SSE2
+    __m128i group16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group16, _mm_set1_epi8(tag))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_SIZE; ++i) {
+        if (bytes[i] == tag) mask |= 1u << i;
     }
-    return "";
+    return mask;
+#endif
 }
 
-SymbolTable::DataType SymbolTable::retrieveDataType(const std::string& varName)
+// Probes group by group from the key's home group; a group with an empty
+// slot ends the search, since an insert would have stopped there
+int SymbolTable::find(const std::string& varName) const
 {
-    if (checkVarExists(varName)) {
-        return symbolTable.at(varName).dataType;
+    uint32_t hash = hashOf(varName);
+    int8_t tag = static_cast<int8_t>(hash & 0x7f);
+    size_t groups = capacity / GROUP_SIZE;
+    size_t group = (hash >> 7) % groups;
+    for (size_t probe = 0; probe < groups; ++probe, group = (group + 1) % groups) {
+        uint32_t matches = matchGroup(group, tag);
+        for (size_t bit = 0; matches; ++bit, matches >>= 1) {
+            if ((matches & 1) && keyEquals(slots()[group * GROUP_SIZE + bit], varName)) {
+                return static_cast<int>(group * GROUP_SIZE + bit);
+            }
+        }
+        if (matchGroup(group, EMPTY)) break;
     }
-    return SymbolTable::DataType::INTEGER;
+    return -1;
+}
+
+bool SymbolTable::keyEquals(const Entry& entry, const std::string& varName) const
+{
+    if (entry.keyLength == SPILLED_KEY) {
+        uint32_t index;
+        std::memcpy(&index, entry.key, sizeof(index));
+        return spill[index] == varName;
+    }
+    return entry.keyLength == varName.size() && std::memcmp(entry.key, varName.data(), varName.size()) == 0;
+}
+
+std::string SymbolTable::keyOf(const Entry& entry) const
+{
+    if (entry.keyLength == SPILLED_KEY) {
+        uint32_t index;
+        std::memcpy(&index, entry.key, sizeof(index));
+        return spill[index];
+    }
+    return std::string(entry.key, entry.keyLength);
+}
+
+bool SymbolTable::checkVarExists(const std::string& varName) const
+{
+    return find(varName) >= 0;
+}
+
+std::string SymbolTable::retrieveValue(const std::string& varName) const
+{
+    int slot = find(varName);
+    if (slot < 0) return "";
+    return formatValue(slots()[slot]);
+}
+
+SymbolTable::DataType SymbolTable::retrieveDataType(const std::string& varName) const
+{
+    int slot = find(varName);
+    if (slot < 0) return SymbolTable::DataType::INTEGER;
+    return slots()[slot].dataType;
+}
+
+bool SymbolTable::retrieveInteger(const std::string& varName, uint16_t& value) const
+{
+    int slot = find(varName);
+    if (slot < 0 || slots()[slot].dataType != DataType::INTEGER) return false;
+    value = slots()[slot].value.integer;
+    return true;
 }
 
 bool SymbolTable::insertVariable(const std::string& varName, DataType dataType, const std::string& value)
 {
-    //if the variable doesn't exist, insert new variable
-    if (!checkVarExists(varName)) {
-        ST entry;
-        entry.dataType = dataType;
-        entry.value = value;
-        symbolTable[varName] = entry;
-        return true;
+    int slot = claimSlot(varName);
+    if (slot < 0) return false;
+    setValue(slots()[slot], dataType, value);
+    return true;
+}
+
+bool SymbolTable::insertVariable(const std::string& varName, uint16_t value)
+{
+    int slot = claimSlot(varName);
+    if (slot < 0) return false;
+    slots()[slot].dataType = DataType::INTEGER;
+    slots()[slot].value.integer = value;
+    return true;
+}
+
+// Takes the first empty or deleted slot on the key's probe sequence and
+// stores the key there; the caller fills in the value. The table grows
+// before it is 7/8 full, so there is always a slot and probes stay short.
+int SymbolTable::claimSlot(const std::string& varName)
+{
+    if (checkVarExists(varName)) return -1;
+    if ((count + deleted + 1) * 8 > capacity * 7) {
+        grow();
+    }
+
+    uint32_t hash = hashOf(varName);
+    size_t groups = capacity / GROUP_SIZE;
+    size_t group = (hash >> 7) % groups;
+    for (size_t probe = 0; probe < groups; ++probe, group = (group + 1) % groups) {
+        uint32_t open = matchGroup(group, EMPTY) | matchGroup(group, DELETED);
+        if (!open) continue;
+
+        size_t bit = 0;
+        while (!(open & 1)) {
+            open >>= 1;
+            ++bit;
+        }
+        size_t slot = group * GROUP_SIZE + bit;
+        Entry& entry = slots()[slot];
+        if (controls()[slot] == DELETED) {
+            deleted--;
+        }
+        if (varName.size() <= INLINE_KEY) {
+            std::memcpy(entry.key, varName.data(), varName.size());
+            entry.keyLength = static_cast<uint8_t>(varName.size());
+        }
+        else {
+            uint32_t index = spillString(varName);
+            std::memcpy(entry.key, &index, sizeof(index));
+            entry.keyLength = SPILLED_KEY;
+        }
+        entry.dataType = DataType::INTEGER;
+        controls()[slot] = static_cast<int8_t>(hash & 0x7f);
+        count++;
+        return static_cast<int>(slot);
+    }
+    return -1;
+}
+
+// Rehashes every live entry into a table twice the size, or the same size
+// when deletions make up most of the load. Entries move as they are, so
+// spilled keys and strings keep their indices.
+void SymbolTable::grow()
+{
+    size_t newCapacity = (count + 1) * 2 > capacity ? capacity * 2 : capacity;
+    size_t newGroups = newCapacity / GROUP_SIZE;
+    std::vector<int8_t> newControl(newCapacity, int8_t(EMPTY));
+    std::vector<Entry> newEntries(newCapacity);
+
+    for (size_t slot = 0; slot < capacity; ++slot) {
+        if (controls()[slot] < 0) continue;
+        const Entry& entry = slots()[slot];
+        uint32_t hash = hashOf(keyOf(entry));
+        for (size_t group = (hash >> 7) % newGroups;; group = (group + 1) % newGroups) {
+            size_t bit = 0;
+            while (bit < GROUP_SIZE && newControl[group * GROUP_SIZE + bit] != EMPTY) {
+                ++bit;
+            }
+            if (bit < GROUP_SIZE) {
+                newControl[group * GROUP_SIZE + bit] = static_cast<int8_t>(hash & 0x7f);
+                newEntries[group * GROUP_SIZE + bit] = entry;
+                break;
+            }
+        }
     }
-    //if the variable does exist, do nothing
-    return false;
-    
+
+    heapControl.swap(newControl);
+    heapEntries.swap(newEntries);
+    capacity = newCapacity;
+    deleted = 0;
 }
 
 bool SymbolTable::removeVariable(const std::string& varName)
 {
-    if (checkVarExists(varName)) {
-        symbolTable.erase(varName);
-        return true;
+    int slot = find(varName);
+    if (slot < 0) return false;
+
+    Entry& entry = slots()[slot];
+    releaseValue(entry);
+    if (entry.keyLength == SPILLED_KEY) {
+        uint32_t index;
+        std::memcpy(&index, entry.key, sizeof(index));
+        releaseSpill(index);
     }
-    return false;
+    controls()[slot] = DELETED;
+    count--;
+    deleted++;
+    return true;
 }
 
 bool SymbolTable::updateVariable(const std::string& varName, const std::string& newValue)
 {
-    if (checkVarExists(varName)) {
+    int slot = find(varName);
+    if (slot < 0) return false;
+
+    Entry& entry = slots()[slot];
+    DataType dataType = entry.dataType;
+    releaseValue(entry);
+    setValue(entry, dataType, newValue);
+    return true;
+}
+
+bool SymbolTable::updateVariable(const std::string& varName, uint16_t value)
+{
+    int slot = find(varName);
+    if (slot < 0) return false;
+
+    Entry& entry = slots()[slot];
+    releaseValue(entry);
+    entry.dataType = DataType::INTEGER;
+    entry.value.integer = value;
+    return true;
+}
+
+void SymbolTable::clear()
+{
+    std::vector<int8_t>().swap(heapControl);
+    std::vector<Entry>().swap(heapEntries);
+    std::memset(inlineControl, EMPTY, sizeof(inlineControl));
+    capacity = INLINE_CAPACITY;
+    count = 0;
+    deleted = 0;
+    spill.clear();
+    freeSpill.clear();
+}
+
+size_t SymbolTable::size() const
+{
+    return count;
+}
+
+std::unordered_map<std::string, SymbolTable::ST> SymbolTable::getSymbolTable() const {
+    std::unordered_map<std::string, ST> view;
+    for (size_t slot = 0; slot < capacity; ++slot) {
+        if (controls()[slot] < 0) continue;
         ST entry;
-        entry.dataType = symbolTable[varName].dataType;
-        entry.value = newValue;
-        symbolTable[varName] = entry;
-        return true;
+        entry.dataType = slots()[slot].dataType;
+        entry.value = formatValue(slots()[slot]);
+        view[keyOf(slots()[slot])] = entry;
+    }
+    return view;
+}
+
+// Values arrive as text and are stored natively; bad numbers read as 0
+void SymbolTable::setValue(Entry& entry, DataType dataType, const std::string& value)
+{
+    entry.dataType = dataType;
+    switch (dataType) {
+    case DataType::INTEGER:
+        entry.value.integer = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 10));
+        break;
+    case DataType::FLOAT:
+        entry.value.floating = std::strtof(value.c_str(), nullptr);
+        break;
+    case DataType::CHAR:
+        entry.value.character = value.empty() ? '\0' : value[0];
+        break;
+    case DataType::STRING:
+        entry.value.spill = spillString(value);
+        break;
     }
-    return false;
 }
 
-const std::unordered_map<std::string, SymbolTable::ST>& SymbolTable::getSymbolTable() const {
-    return symbolTable;
-}
\ No newline at end of file
+std::string SymbolTable::formatValue(const Entry& entry) const
+{
+    switch (entry.dataType) {
+    case DataType::INTEGER:
+        return std::to_string(entry.value.integer);
+    case DataType::FLOAT: {
+        std::ostringstream text;
+        text << entry.value.floating;
+        return text.str();
+    }
+    case DataType::CHAR:
+        return entry.value.character ? std::string(1, entry.value.character) : "";
+    case DataType::STRING:
+        return spill[entry.value.spill];
+    }
+    return "";
+}
+
+void SymbolTable::releaseValue(Entry& entry)
+{
+    if (entry.dataType == DataType::STRING) {
+        releaseSpill(entry.value.spill);
+    }
+}
+
+uint32_t SymbolTable::spillString(const std::string& text)
+{
+    if (!freeSpill.empty()) {
+        uint32_t index = freeSpill.back();
+        freeSpill.pop_back();
+        spill[index] = text;
+        return index;
+    }
+    spill.push_back(text);
+    return static_cast<uint32_t>(spill.size() - 1);
+}
+
+void SymbolTable::releaseSpill(uint32_t index)
+{
+    spill[index].clear();
+    spill[index].shrink_to_fit();
+    freeSpill.push_back(index);
+}
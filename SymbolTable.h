@@ -1,31 +1,97 @@
 #pragma once
+#include <cstdint>
 #include <unordered_map>
 #include <string>
 #include <vector>
 
+// Variables in an open-addressed table probed in groups of 16 slots. Each
+// slot has a control byte holding 7 bits of its key's hash, and a lookup
+// compares a whole group's control bytes at once. The first INLINE_CAPACITY
+// slots live in the table itself, and keys of up to INLINE_KEY bytes and
+// non-string values are stored in the slot, so a typical program's table
+// never allocates; a bigger one moves to the heap and doubles as it fills.
 class SymbolTable {
 public:
-    enum class DataType {
+    enum class DataType : uint8_t {
         INTEGER = 0,
         STRING = 1,
         FLOAT = 2,
         CHAR = 3,
     };
 
+    // Display form of an entry
     class ST {
     public:
         DataType dataType;
         std::string value;
     };
 
+    SymbolTable();
 
-    bool checkVarExists(const std::string& varName);
-    std::string retrieveValue(const std::string& varName);
-    DataType retrieveDataType(const std::string& varName);
+    bool checkVarExists(const std::string& varName) const;
+    std::string retrieveValue(const std::string& varName) const;
+    DataType retrieveDataType(const std::string& varName) const;
+    bool retrieveInteger(const std::string& varName, uint16_t& value) const;
+    // Fails if the variable exists
     bool insertVariable(const std::string& varName, DataType dataType, const std::string& value);
+    bool insertVariable(const std::string& varName, uint16_t value);
     bool removeVariable(const std::string& varName);
     bool updateVariable(const std::string& varName, const std::string& value);
-    const std::unordered_map<std::string, ST>& getSymbolTable() const;
+    bool updateVariable(const std::string& varName, uint16_t value);
+    void clear();
+    size_t size() const;
+    // Built on request for display
+    std::unordered_map<std::string, ST> getSymbolTable() const;
+
 private:
-    std::unordered_map<std::string, ST> symbolTable;
-};
\ No newline at end of file
+    static constexpr size_t INLINE_CAPACITY = 32;
+    static constexpr size_t GROUP_SIZE = 16;
+    static constexpr size_t INLINE_KEY = 14;
+    static constexpr uint8_t SPILLED_KEY = 0xff;  // key bytes hold a spill index
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    struct Entry {
+        char key[INLINE_KEY];
+        uint8_t keyLength;
+        DataType dataType;
+        union {
+            uint16_t integer;
+            float floating;
+            char character;
+            uint32_t spill;  // STRING values live in spill
+        } value;
+    };
+
+    static uint32_t hashOf(const std::string& varName);
+    // Bit i set for each slot of the group whose control byte is tag
+    uint32_t matchGroup(size_t group, int8_t tag) const;
+    int find(const std::string& varName) const;
+    int claimSlot(const std::string& varName);
+    void grow();
+    int8_t* controls();
+    const int8_t* controls() const;
+    Entry* slots();
+    const Entry* slots() const;
+    bool keyEquals(const Entry& entry, const std::string& varName) const;
+    std::string keyOf(const Entry& entry) const;
+    void setValue(Entry& entry, DataType dataType, const std::string& value);
+    std::string formatValue(const Entry& entry) const;
+    void releaseValue(Entry& entry);
+
+    uint32_t spillString(const std::string& text);
+    void releaseSpill(uint32_t index);
+
+    size_t capacity = INLINE_CAPACITY;
+    size_t count = 0;
+    size_t deleted = 0;
+    int8_t inlineControl[INLINE_CAPACITY];
+    Entry inlineEntries[INLINE_CAPACITY];
+    // Replace the inline arrays once the table outgrows them
+    std::vector<int8_t> heapControl;
+    std::vector<Entry> heapEntries;
+
+    // Long keys and string values, which typical programs never have
+    std::vector<std::string> spill;
+    std::vector<uint32_t> freeSpill;
+};
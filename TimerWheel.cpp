@@ -0,0 +1,132 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel(uint64_t startTick) : currentTick(startTick) {
+}
+
+void TimerWheel::schedule(uint64_t expiry, std::shared_ptr<Process> process) {
+    timerCount++;
+    place({ expiry, process });
+}
+
+// A timer goes on the lowest level whose window it shares with the current
+// tick, so every timer on level n expires before any timer on level n + 1.
+void TimerWheel::place(Timer timer) {
+    if (timer.expiry <= currentTick) {
+        overdue.push_back(timer);
+        return;
+    }
+
+    for (int level = 0; level < LEVELS; ++level) {
+        int shift = SLOT_BITS * (level + 1);
+        if ((timer.expiry >> shift) == (currentTick >> shift)) {
+            size_t slot = (timer.expiry >> (SLOT_BITS * level)) & SLOT_MASK;
+            wheel[level][slot].push_back(timer);
+            levelCount[level]++;
+            return;
+        }
+    }
+    overflow.push_back(timer);
+}
+
+void TimerWheel::cascade(int level) {
+    std::vector<Timer> timers;
+    if (level == LEVELS) {
+        timers.swap(overflow);
+    }
+    else {
+        size_t slot = (currentTick >> (SLOT_BITS * level)) & SLOT_MASK;
+        timers.swap(wheel[level][slot]);
+        levelCount[level] -= timers.size();
+    }
+    for (auto& timer : timers) {
+        place(timer);
+    }
+}
+
+void TimerWheel::advance(uint64_t now, std::vector<std::shared_ptr<Process>>& expired) {
+    for (auto& timer : overdue) {
+        expired.push_back(timer.process);
+    }
+    timerCount -= overdue.size();
+    overdue.clear();
+
+    while (currentTick < now) {
+        if (timerCount == 0) {
+            currentTick = now;
+            break;
+        }
+
+        // Nothing can fire before the next window of the lowest occupied
+        // level, so skip straight to its boundary
+        int emptyLevels = 0;
+        while (emptyLevels < LEVELS && levelCount[emptyLevels] == 0) {
+            emptyLevels++;
+        }
+        if (emptyLevels > 0) {
+            uint64_t windowEnd = currentTick | ((uint64_t(1) << (SLOT_BITS * emptyLevels)) - 1);
+            if (windowEnd >= now) {
+                currentTick = now;
+                break;
+            }
+            currentTick = windowEnd;
+        }
+
+        currentTick++;
+
+        // Entering a new window on some level pulls its slot down, highest first
+        int boundary = 0;
+        while (boundary < LEVELS &&
+            ((currentTick >> (SLOT_BITS * (boundary + 1))) << (SLOT_BITS * (boundary + 1))) == currentTick) {
+            boundary++;
+        }
+        for (int level = boundary; level >= 1; --level) {
+            cascade(level);
+        }
+
+        auto& slot = wheel[0][currentTick & SLOT_MASK];
+        for (auto& timer : slot) {
+            expired.push_back(timer.process);
+        }
+        timerCount -= slot.size();
+        levelCount[0] -= slot.size();
+        slot.clear();
+
+        for (auto& timer : overdue) {
+            expired.push_back(timer.process);
+        }
+        timerCount -= overdue.size();
+        overdue.clear();
+    }
+}
+
+uint64_t TimerWheel::nextExpiry() const {
+    if (!overdue.empty()) return currentTick;
+
+    for (int level = 0; level < LEVELS; ++level) {
+        size_t first = (currentTick >> (SLOT_BITS * level)) & SLOT_MASK;
+        // The current slot on upper levels has already been cascaded
+        if (level > 0) first++;
+
+        for (size_t slot = first; slot < SLOTS; ++slot) {
+            const auto& timers = wheel[level][slot];
+            if (timers.empty()) continue;
+
+            uint64_t earliest = NO_TIMER;
+            for (const auto& timer : timers) {
+                earliest = std::min(earliest, timer.expiry);
+            }
+            return earliest;
+        }
+    }
+
+    uint64_t earliest = NO_TIMER;
+    for (const auto& timer : overflow) {
+        earliest = std::min(earliest, timer.expiry);
+    }
+    return earliest;
+}
+
+size_t TimerWheel::size() const {
+    return timerCount;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Process.h"
+
+// Hierarchical timer wheel keyed on CPUTick ticks. Level 0 holds timers that
+// expire within the current 64-tick window; each level above covers 64 times
+// the range of the one below and is cascaded down as the window moves.
+// Not thread-safe; the owner guards it.
+class TimerWheel {
+public:
+    static constexpr uint64_t NO_TIMER = UINT64_MAX;
+
+    explicit TimerWheel(uint64_t startTick = 0);
+
+    void schedule(uint64_t expiry, std::shared_ptr<Process> process);
+    void advance(uint64_t now, std::vector<std::shared_ptr<Process>>& expired);
+    uint64_t nextExpiry() const;
+    size_t size() const;
+
+private:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+
+    struct Timer {
+        uint64_t expiry;
+        std::shared_ptr<Process> process;
+    };
+
+    void place(Timer timer);
+    void cascade(int level);
+
+    uint64_t currentTick;
+    size_t timerCount = 0;
+    std::array<std::array<std::vector<Timer>, SLOTS>, LEVELS> wheel;
+    std::array<size_t, LEVELS> levelCount{};
+    std::vector<Timer> overdue;
+    std::vector<Timer> overflow;
+};
@@ -11,13 +11,42 @@ using namespace std;
 #include <fstream>
 #include <vector>
 #include <climits>
+#include <algorithm>
+#include <thread>
 
 #include "Scheduler.h"
+#include "QueueBenchmark.h"
 #include "Process.h"
 #include "FCFS.h"
 #include "RoundRobin.h"
+#include "MLFQ.h"
+#include "SJF.h"
+#include "EDF.h"
+#include "Stride.h"
+#include "Partitioned.h"
 #include "CPUTick.h"
 
+// One "first-last:policy:class" entry of the partitions line
+struct PartitionSpec {
+    int firstCore = 0;
+    int coreCount = 1;
+    std::string policy;
+    std::string jobClass = "any";
+};
+
+// The ranges, in any order, have to cover cores 0 to n-1 exactly once, since
+// core numbers are how the partitions are told apart
+bool partitionsTileCores(std::vector<PartitionSpec> partitions) {
+    std::sort(partitions.begin(), partitions.end(),
+        [](const PartitionSpec& a, const PartitionSpec& b) { return a.firstCore < b.firstCore; });
+    int nextCore = 0;
+    for (const auto& spec : partitions) {
+        if (spec.firstCore != nextCore) return false;
+        nextCore += spec.coreCount;
+    }
+    return true;
+}
+
 // In main.cpp
 struct Config {
     int num_cpu = 0;
@@ -31,10 +60,33 @@ struct Config {
     size_t mem_per_frame = 16;       
     size_t min_mem_per_proc = 2048;      
     size_t max_mem_per_proc = 4096;
+    std::string clock_mode = "real";
+    int mlfq_levels = 3;
+    std::vector<unsigned> mlfq_quanta;
+    uint64_t mlfq_boost = 0;
+    uint64_t deadline_ticks = 0;
+    std::string edf_admission = "flag";
+    int batch_tickets = 100;
+    int screen_tickets = 100;
+    std::vector<PartitionSpec> partitions;
+    size_t partition_long_ins = 1000;
+    int host_threads = 0;
+    std::string cpu_affinity = "none";
+    std::string quantum_mode = "static";
+    unsigned quantum_min = 1;
+    unsigned quantum_max = 64;
+    double switch_overhead_target = 5;
+    unsigned affinity_imbalance = 1;
+    int max_cpu = 0;
+    std::string autoscale = "off";
+    int min_cpu = 1;
+    unsigned autoscale_depth = 2;
+    uint64_t autoscale_cooldown = 50;
     bool initialized = false;
     std::atomic<bool> populate_running{ false };
     std::mutex populate_mutex;
     std::condition_variable populate_cv;
+    std::thread populate_thread;
 };
 
 class ConsoleGeneral {
@@ -192,89 +244,93 @@ string trim(const string& str) {
     return str.substr(first, last - first + 1);
 }
 
+// The process's declared variables for process-smi, by name
+void printVariables(const Process& process) {
+    auto view = process.getSymbolTable().getSymbolTable();
+    map<string, string> variables;
+    for (const auto& entry : view) {
+        variables[entry.first] = entry.second.value;
+    }
+
+    cout << "Variables:" << (variables.empty() ? " none" : "") << "\n";
+    for (const auto& variable : variables) {
+        cout << "  " << variable.first << " = " << variable.second << "\n";
+    }
+}
+
+// Fills a process with a random program of min-ins to max-ins instructions.
+// PRINT greets with the running process's name, so identical draws share one
+// program.
+void generateInstructions(const Config& config, const shared_ptr<Process>& process) {
+    // Generate random number of instructions
+    int numInstructions = config.min_ins + rand() % (config.max_ins - config.min_ins + 1);
+
+    // Add instructions to the process
+    Program program;
+    for (int j = 0; j < numInstructions; j++) {
+        int instructionType = rand() % 5;
+        switch (instructionType) {
+            case 0: {
+                program.print("Hello from ", true);
+                break;
+            }
+            case 1: {
+                std::string varName = "var";
+                uint16_t value = 10;
+                program.declare(varName, value);
+                break;
+            }
+            case 2: {
+                std::string destVar = "0";
+                std::string src1 = std::to_string(rand() % 50);
+                std::string src2 = std::to_string(rand() % 50);
+
+                program.add(destVar, src1, src2);
+                break;
+            }
+            case 3: {
+                std::string destVar = "var1";
+                std::string src1 = std::to_string(rand() % 50);
+                std::string src2 = std::to_string(rand() % 50);
+
+                program.subtract(destVar, src1, src2);
+                break;
+            }
+            case 4: {
+                uint8_t sleepCycles = static_cast<uint8_t>((rand() % 10) + 1);
+
+                program.sleep(sleepCycles);
+                break;
+            }
+            case 5: {
+                break;
+            }
+        
+        }
+    }
+    process->loadProgram(Program::share(std::move(program)));
+}
+
 void populateProcesses(Config& config, ConsoleManager& consoleManager, unique_ptr<Scheduler>& scheduler) {
-    static int processCounter = 0;  // Counter for unique process names
+    CPUTick& clock = scheduler->getClock();
+    clock.attach();
 
     while (config.populate_running) {
         // Create a new process with a unique name
-        string processName = "process_" + to_string(processCounter++);
+        int processId = ProcessHandler::allocatePid();
+        string processName = "process_" + to_string(processId);
 
         // Create the process and screen
         size_t mem_per_proc = config.min_mem_per_proc + rand() % (config.max_mem_per_proc - config.min_mem_per_proc + 1);
 
-        auto process = make_shared<Process>(processName, processCounter, mem_per_proc);
+        auto process = make_shared<Process>(processName, processId, mem_per_proc);
         consoleManager.addNewScreen(processName, process, mem_per_proc);
 
-        // Generate random number of instructions
-        int numInstructions = config.min_ins + rand() % (config.max_ins - config.min_ins + 1);
-
-        // Add instructions to the process
-        for (int j = 0; j < numInstructions && config.populate_running; j++) {
-            int instructionType = rand() % 5;
-            switch (instructionType) {
-                case 0: {
-                    auto printInstr = make_shared<PrintInstruction>(
-                        process.get(),
-                        "Hello from " + processName
-                    );
-                    process->addInstruction(printInstr);
-                    break;
-                }
-                case 1: {
-                    std::string varName = "var";
-                    uint16_t value = 10;
-                    auto declareInstr = make_shared<DeclareInstruction>(
-                        process.get(),
-                        varName,
-                        value
-                    );
-                    process->addInstruction(declareInstr);
-                    break;
-                }
-                case 2: {
-                    std::string destVar = "0";
-                    std::string src1 = std::to_string(rand() % 50);
-                    std::string src2 = std::to_string(rand() % 50);
-
-                    auto addInstr = make_shared<AddInstruction>(
-                        process.get(),
-                        destVar,
-                        src1,
-                        src2
-                    );
-                    process->addInstruction(addInstr);
-                    break;
-                }
-                case 3: {
-                    std::string destVar = "var1";
-                    std::string src1 = std::to_string(rand() % 50);
-                    std::string src2 = std::to_string(rand() % 50);
-
-                    auto subInstr = make_shared<SubtractInstruction>(
-                        process.get(),
-                        destVar,
-                        src1,
-                        src2
-                    );
-                    process->addInstruction(subInstr);
-                    break;
-                }
-                case 4: {
-                    std::string sleepCycles = std::to_string((rand() % 10) + 1);
-
-                    auto sleepInstr = make_shared<SleepInstruction>(
-                        process.get(),
-                        sleepCycles
-                    );
-                    process->addInstruction(sleepInstr);
-                    break;
-                }
-                case 5: {
-                    break;
-                }
-            
-            }
+        generateInstructions(config, process);
+        if (config.deadline_ticks > 0) {
+            process->setDeadline(clock.getTick() + config.deadline_ticks);
         }
+        process->setTickets(config.batch_tickets);
 
         if (config.populate_running) {
             try {
@@ -286,12 +342,109 @@ void populateProcesses(Config& config, ConsoleManager& consoleManager, unique_pt
         }
 
         // Wait for the configured delay or until stopped
+        if (clock.isVirtual()) {
+            clock.waitTicks(config.batch_process_freq);
+            continue;
+        }
         unique_lock<mutex> lock(config.populate_mutex);
         config.populate_cv.wait_for(lock,
             chrono::milliseconds(config.batch_process_freq),
             [&config] { return !config.populate_running; });
     }
+
+    clock.detach();
+}
+// Stops the generator and waits for it, so it never outlives the scheduler
+// and clock it holds
+void stopPopulation(Config& config) {
+    {
+        lock_guard<mutex> lock(config.populate_mutex);
+        config.populate_running = false;
+    }
+    config.populate_cv.notify_all();
+    if (config.populate_thread.joinable()) {
+        config.populate_thread.join();
+    }
+}
+
+// Builds the scheduler for one policy; partitions reuse it for their cores
+unique_ptr<Scheduler> createScheduler(const std::string& policy, int numCores, const Config& config) {
+    if (policy == "fcfs") {
+        return std::unique_ptr<Scheduler>(new FCFSScheduler(
+            numCores,
+            config.max_overall_mem,
+            config.mem_per_frame,
+            config.delays_per_exec));
+    }
+    else if (policy == "rr") {
+        auto rr = std::make_unique<RRScheduler>(
+            numCores,
+            config.quantum_cycles,
+            config.delays_per_exec,
+            config.max_overall_mem,
+            config.mem_per_frame
+            );
+        rr->setAffinityImbalance(config.affinity_imbalance);
+        if (config.quantum_mode == "adaptive") {
+            rr->setAdaptiveQuantum(config.quantum_min, config.quantum_max, config.switch_overhead_target / 100);
+        }
+        return rr;
+    }
+    else if (policy == "sjf" || policy == "srtf") {
+        return std::make_unique<SJFScheduler>(
+            numCores,
+            policy == "srtf",
+            config.quantum_cycles,
+            config.delays_per_exec,
+            config.max_overall_mem,
+            config.mem_per_frame
+            );
+    }
+    else if (policy == "edf") {
+        return std::make_unique<EDFScheduler>(
+            numCores,
+            config.quantum_cycles,
+            config.edf_admission == "reject",
+            config.delays_per_exec,
+            config.max_overall_mem,
+            config.mem_per_frame
+            );
+    }
+    else if (policy == "stride") {
+        return std::make_unique<StrideScheduler>(
+            numCores,
+            config.quantum_cycles,
+            config.delays_per_exec,
+            config.max_overall_mem,
+            config.mem_per_frame
+            );
+    }
+    else if (policy == "mlfq") {
+        // Levels without an explicit quantum double the one above
+        std::vector<unsigned> levelQuanta;
+        for (int i = 0; i < std::max(1, config.mlfq_levels); ++i) {
+            if (i < static_cast<int>(config.mlfq_quanta.size())) {
+                levelQuanta.push_back(std::max(1u, config.mlfq_quanta[i]));
+            }
+            else if (i == 0) {
+                levelQuanta.push_back(static_cast<unsigned>(std::max(1, config.quantum_cycles)));
+            }
+            else {
+                levelQuanta.push_back(levelQuanta.back() * 2);
+            }
+        }
+        return std::make_unique<MLFQScheduler>(
+            numCores,
+            levelQuanta,
+            config.mlfq_boost,
+            config.delays_per_exec,
+            config.max_overall_mem,
+            config.mem_per_frame
+            );
+    }
+    return nullptr;
 }
+
 int main() {
     Config config;
     string inputCommand;
@@ -305,6 +458,8 @@ int main() {
 
         getline(cin, inputCommand);
         if (inputCommand == "initialize") {
+            // The generator feeds the scheduler this is about to replace
+            stopPopulation(config);
             string value;
             ifstream configFile("config.txt");
             if (configFile) {
@@ -325,6 +480,55 @@ int main() {
                         else if (key == "mem-per-frame") iss >> config.mem_per_frame;
                         else if (key == "min-mem-per-proc") iss >> config.min_mem_per_proc;
                         else if (key == "max-mem-per-proc") iss >> config.max_mem_per_proc;
+                        else if (key == "clock-mode") iss >> config.clock_mode;
+                        else if (key == "mlfq-levels") iss >> config.mlfq_levels;
+                        else if (key == "mlfq-boost") iss >> config.mlfq_boost;
+                        else if (key == "deadline-ticks") iss >> config.deadline_ticks;
+                        else if (key == "edf-admission") iss >> config.edf_admission;
+                        else if (key == "batch-tickets") iss >> config.batch_tickets;
+                        else if (key == "screen-tickets") iss >> config.screen_tickets;
+                        else if (key == "host-threads") iss >> config.host_threads;
+                        else if (key == "cpu-affinity") iss >> config.cpu_affinity;
+                        else if (key == "quantum-mode") iss >> config.quantum_mode;
+                        else if (key == "quantum-min") iss >> config.quantum_min;
+                        else if (key == "quantum-max") iss >> config.quantum_max;
+                        else if (key == "switch-overhead-target") iss >> config.switch_overhead_target;
+                        else if (key == "affinity-imbalance") iss >> config.affinity_imbalance;
+                        else if (key == "max-cpu") iss >> config.max_cpu;
+                        else if (key == "autoscale") iss >> config.autoscale;
+                        else if (key == "min-cpu") iss >> config.min_cpu;
+                        else if (key == "autoscale-depth") iss >> config.autoscale_depth;
+                        else if (key == "autoscale-cooldown") iss >> config.autoscale_cooldown;
+                        else if (key == "partition-long-ins") iss >> config.partition_long_ins;
+                        else if (key == "partitions") {
+                            config.partitions.clear();
+                            string entry;
+                            while (iss >> entry) {
+                                PartitionSpec spec;
+                                int lastCore = -1;
+                                char dash = 0, colon = 0;
+                                istringstream entryStream(entry);
+                                entryStream >> spec.firstCore >> dash >> lastCore >> colon;
+                                getline(entryStream, spec.policy, ':');
+                                getline(entryStream, spec.jobClass);
+                                if (dash != '-' || colon != ':' || spec.policy.empty() || lastCore < spec.firstCore) {
+                                    cout << "Ignoring malformed partition: " << entry << "\n";
+                                    continue;
+                                }
+                                if (spec.jobClass.empty()) spec.jobClass = "any";
+                                spec.coreCount = lastCore - spec.firstCore + 1;
+                                config.partitions.push_back(spec);
+                            }
+                            if (!partitionsTileCores(config.partitions)) {
+                                cout << "Invalid partitions: core ranges must start at 0 and neither overlap nor leave gaps\n";
+                                config.partitions.clear();
+                            }
+                        }
+                        else if (key == "mlfq-quanta") {
+                            config.mlfq_quanta.clear();
+                            unsigned quantum;
+                            while (iss >> quantum) config.mlfq_quanta.push_back(quantum);
+                        }
 
                     }
                 }
@@ -341,25 +545,68 @@ int main() {
                     << "Maximum memory: " << config.max_overall_mem << "\n"
                     << "Memory per frame: " << config.mem_per_frame << "\n"
                     << "Minimum process memory: " << config.min_mem_per_proc << "\n"
-                    << "Maxiimum process memory: " << config.max_mem_per_proc << "\n";
-
-                if (config.scheduler == "fcfs") {
-                    scheduler = std::unique_ptr<Scheduler>(new FCFSScheduler(
-                        config.num_cpu,
-                        config.max_overall_mem,
-                        config.mem_per_frame,
-                        config.delays_per_exec));
-                    scheduler->start();
+                    << "Maxiimum process memory: " << config.max_mem_per_proc << "\n"
+                    << "Clock mode: " << config.clock_mode << "\n"
+                    << "CPU affinity: " << config.cpu_affinity << "\n";
+
+                // Such processes could only ever wait for memory, so they are
+                // turned away as they arrive
+                if (config.scheduler != "fcfs" && config.max_mem_per_proc > config.max_overall_mem) {
+                    cout << "Processes needing more than max-overall-mem (" << config.max_overall_mem
+                        << ") will be rejected; max-mem-per-proc is " << config.max_mem_per_proc << "\n";
+                }
+
+                if (config.scheduler == "partitioned") {
+                    std::vector<PartitionedScheduler::Partition> partitions;
+                    for (const auto& spec : config.partitions) {
+                        auto partitionScheduler = createScheduler(spec.policy, spec.coreCount, config);
+                        // Skipping one would leave a gap in the cores
+                        if (!partitionScheduler) {
+                            cout << "Unknown partition scheduler: " << spec.policy << "\n";
+                            partitions.clear();
+                            break;
+                        }
+                        partitions.push_back({ spec.firstCore, spec.coreCount, spec.policy, spec.jobClass,
+                            std::move(partitionScheduler) });
+                    }
+                    if (!partitions.empty()) {
+                        scheduler = std::make_unique<PartitionedScheduler>(
+                            std::move(partitions),
+                            config.partition_long_ins,
+                            config.max_overall_mem,
+                            config.mem_per_frame
+                            );
+                    }
+                }
+                else {
+                    // Cores up to max-cpu are allocated so the count can grow later
+                    scheduler = createScheduler(config.scheduler, std::max(config.num_cpu, config.max_cpu), config);
+                    if (scheduler) {
+                        scheduler->setActiveCores(config.num_cpu);
+                        if (config.autoscale == "on") {
+                            scheduler->setAutoscale(config.min_cpu, config.autoscale_depth, config.autoscale_cooldown);
+                        }
+                    }
                 }
-                else if (config.scheduler == "rr") {
-                    scheduler = std::make_unique<RRScheduler>(
-                        config.num_cpu,
-                        config.quantum_cycles,
-                        config.delays_per_exec,
-                        config.max_overall_mem,
-                        config.mem_per_frame
-                        );
+
+                if (scheduler) {
+                    scheduler->setHostThreads(config.host_threads);
+                    if (config.clock_mode == "virtual") {
+                        scheduler->getClock().startVirtual();
+                    }
+                    else {
+                        scheduler->getClock().start(1);
+                    }
+                    CpuAffinity cpuAffinity(config.cpu_affinity);
+                    if (!cpuAffinity.isValid()) {
+                        cout << "Invalid cpu-affinity " << config.cpu_affinity << ", threads are not pinned\n";
+                    }
+                    scheduler->setCpuAffinity(cpuAffinity);
                     scheduler->start();
+
+                    for (const auto& line : scheduler->describeAffinity()) {
+                        cout << line << "\n";
+                    }
                 }
             }
             else {
@@ -372,8 +619,9 @@ int main() {
             std::istringstream iss(inputCommand.substr(10));
             string name;
             size_t memorySize = 64;   
+            uint64_t deadlineTicks = 0;
 
-            iss >> name >> memorySize;
+            iss >> name >> memorySize >> deadlineTicks;
             name = trim(name);
             if (consoleManager.findScreenSessions(name)) {
                 cout << "Screen already exists. Please type another name.\n";
@@ -384,13 +632,24 @@ int main() {
             }
             
             else {
-                static int processId = 0;
                 size_t mem_per_proc = config.min_mem_per_proc + rand() % (config.max_mem_per_proc - config.min_mem_per_proc + 1);
 
-                auto process = make_shared<Process>(name, processId++, mem_per_proc);   
+                auto process = make_shared<Process>(name, ProcessHandler::allocatePid(), mem_per_proc);   
+
+                if (scheduler) {
+                    generateInstructions(config, process);
+                    if (deadlineTicks > 0) {
+                        process->setDeadline(scheduler->getClock().getTick() + deadlineTicks);
+                    }
+                    process->setTickets(config.screen_tickets);
+                    scheduler->addProcess(process);
+                }
 
                 consoleManager.addNewScreen(name, process, memorySize);
                 consoleManager.initializeScreen();
+                if (process->getState() == ProcessState::Rejected) {
+                    cout << "Process was rejected: " << process->getRejectionReason() << "\n";
+                }
 
                 string subCommand;
                 while (getline(cin, subCommand)) {
@@ -410,10 +669,14 @@ int main() {
                         for (const auto& log : logs) {
                             cout << log << "\n";  
                         }
+                        printVariables(*process);
 
                         if (process->getIsFinished()) {
                             cout << "Finished!\n";
                         }
+                        else if (process->getState() == ProcessState::Rejected) {
+                            cout << "Rejected: " << process->getRejectionReason() << "\n";
+                        }
                         else {
                             cout << "Current instruction: " << process->getCurrentInstructionIndex() + 1
                                 << "/" << process->getInstructionCount() << "\n";
@@ -462,11 +725,15 @@ int main() {
                     for (const auto& log : logs) {
                         cout << log << "\n"; 
                     }
+                    printVariables(*process);
 
                     if (process->getIsFinished()) {
                         cout << "Finished!\n";
                         cout << "===================\n";
                     }
+                    else if (process->getState() == ProcessState::Rejected) {
+                        cout << "Rejected: " << process->getRejectionReason() << "\n";
+                    }
                     else {
                         cout << "Current instruction: " << process->getCurrentInstructionIndex() + 1
                             << "/" << process->getInstructionCount() << "\n";
@@ -496,11 +763,10 @@ int main() {
             }
 
             config.populate_running = true;
-            thread populate_thread(populateProcesses,
+            config.populate_thread = thread(populateProcesses,
                 ref(config),
                 ref(consoleManager),
                 ref(scheduler));
-            populate_thread.detach();
             cout << "Started automatic process population (frequency: "
                 << config.batch_process_freq << "ms)\n";
         }
@@ -511,13 +777,31 @@ int main() {
                 continue;
             }
 
-            {
-                lock_guard<mutex> lock(config.populate_mutex);
-                config.populate_running = false;
-            }
-            config.populate_cv.notify_all();
+            stopPopulation(config);
             cout << "Stopped automatic process population.\n";
             }
+        else if (inputCommand == "cores" || inputCommand.rfind("cores ", 0) == 0) {
+            std::istringstream iss(inputCommand.substr(5));
+            int cores = 0;
+            if (!scheduler) {
+                std::cout << "Error: Scheduler not initialized.\n";
+            }
+            else if (!(iss >> cores)) {
+                std::cout << "Active cores: " << scheduler->getActiveCores() << "\n";
+            }
+            else if (!scheduler->setActiveCores(cores)) {
+                std::cout << "Error: this scheduler cannot change its core count.\n";
+            }
+            else {
+                std::cout << "Active cores: " << scheduler->getActiveCores() << "\n";
+            }
+        }
+        else if (inputCommand.rfind("bench-queue", 0) == 0) {
+            std::istringstream iss(inputCommand.substr(11));
+            int maxThreads = 64;
+            iss >> maxThreads;
+            runQueueBenchmark(std::max(1, maxThreads), 100000, std::cout);
+        }
         else if (inputCommand == "report-util") {
             if (!scheduler) {
                 std::cout << "Error: Scheduler not initialized.\n";
@@ -546,6 +830,7 @@ int main() {
             consoleManager.initializeScreen();
         }
         else if (inputCommand == "exit") {
+            stopPopulation(config);
             if (scheduler) {
                 scheduler->stop();
             }